@@ -0,0 +1,193 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_Affinity class.
+Pinning uses the Linux scheduler affinity calls; on other systems the
+policies are accepted but threads are left where the scheduler puts them.
+
+*/
+
+#include "ECE_Affinity.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#if defined(__linux__)
+#include <dirent.h>
+#include <pthread.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+ECE_Affinity::ECE_Affinity() : numNodes(1) {
+    readTopology();
+}
+
+bool ECE_Affinity::parseCpuList(const std::string& text, std::vector<int>& list) {
+    list.clear();
+    const char* p = text.c_str();
+    while (*p != '\0' && *p != '\n') {
+        char* end;
+        long first = std::strtol(p, &end, 10);
+        if (end == p || first < 0) {
+            return false;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = std::strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first) {
+                return false;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            list.push_back(int(cpu));
+        }
+        if (*p == ',') {
+            ++p;
+        }
+    }
+    return !list.empty();
+}
+
+void ECE_Affinity::readTopology() {
+    const int numCpus = std::max(1, int(std::thread::hardware_concurrency()));
+    cpuNode.assign(numCpus, 0);
+    numNodes = 1;
+#if defined(__linux__)
+    // The process mask, saved before any of our threads is pinned to a single CPU
+    cpu_set_t mask;
+    allowed.assign(CPU_SETSIZE, false);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            allowed[cpu] = CPU_ISSET(cpu, &mask);
+        }
+    }
+
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (dir == nullptr) {
+        return;
+    }
+    while (dirent* entry = readdir(dir)) {
+        int node;
+        char extra;
+        if (std::sscanf(entry->d_name, "node%d%c", &node, &extra) != 1) {
+            continue;
+        }
+        std::ifstream file(std::string("/sys/devices/system/node/") + entry->d_name + "/cpulist");
+        std::string text;
+        std::vector<int> list;
+        if (std::getline(file, text) && parseCpuList(text, list)) {
+            for (int cpu : list) {
+                if (cpu >= int(cpuNode.size())) {
+                    cpuNode.resize(cpu + 1, 0);
+                }
+                cpuNode[cpu] = node;
+            }
+            numNodes = std::max(numNodes, node + 1);
+        }
+    }
+    closedir(dir);
+#else
+    allowed.assign(numCpus, true);
+#endif
+}
+
+bool ECE_Affinity::isUsable(int cpu) const {
+    return cpu >= 0 && cpu < int(allowed.size()) && allowed[cpu];
+}
+
+bool ECE_Affinity::setPolicy(const std::string& spec) {
+    cpus.clear();
+    if (spec == "none") {
+        return true;
+    }
+    if (spec != "compact" && spec != "scatter") {
+        if (!parseCpuList(spec, cpus)) {
+            std::cerr << "Invalid affinity: " << spec << std::endl;
+            return false;
+        }
+        for (int cpu : cpus) {
+            if (!isUsable(cpu)) {
+                std::cerr << "CPU " << cpu << " is not available." << std::endl;
+                cpus.clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The usable CPUs of every node, in CPU order
+    std::vector<std::vector<int>> nodeCpus(numNodes);
+    for (int cpu = 0; cpu < int(cpuNode.size()); ++cpu) {
+        if (isUsable(cpu)) {
+            nodeCpus[cpuNode[cpu]].push_back(cpu);
+        }
+    }
+    if (spec == "compact") {
+        for (const std::vector<int>& list : nodeCpus) {
+            cpus.insert(cpus.end(), list.begin(), list.end());
+        }
+    } else {
+        for (std::size_t rank = 0; cpus.size() < cpuNode.size(); ++rank) {
+            bool added = false;
+            for (const std::vector<int>& list : nodeCpus) {
+                if (rank < list.size()) {
+                    cpus.push_back(list[rank]);
+                    added = true;
+                }
+            }
+            if (!added) {
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+bool ECE_Affinity::pinThread(int thread) const {
+    if (cpus.empty()) {
+        return true;
+    }
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(getCpu(thread), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return true;
+#endif
+}
+
+int ECE_Affinity::getNodeOfCpu(int cpu) const {
+    return cpu >= 0 && cpu < int(cpuNode.size()) ? cpuNode[cpu] : 0;
+}
+
+int ECE_Affinity::getCurrentNode() const {
+#if defined(__linux__)
+    return getNodeOfCpu(sched_getcpu());
+#else
+    return 0;
+#endif
+}
+
+int ECE_Affinity::getNodeOfAddress(const void* address) const {
+#if defined(__linux__)
+    // get_mempolicy through syscall, so there is no libnuma to link
+    int node = 0;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0, const_cast<void*>(address),
+                MPOL_F_NODE | MPOL_F_ADDR) == 0 && node >= 0 && node < numNodes) {
+        return node;
+    }
+#endif
+    return 0;
+}
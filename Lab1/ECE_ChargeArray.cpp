@@ -0,0 +1,143 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_ChargeArray class.
+The field kernel is selected at compile time: AVX-512 (8 charges per step),
+AVX2 + FMA (4 charges per step), or a scalar loop. The remainder of a range
+that does not fill a register is always handled by the scalar loop.
+
+*/
+
+#include "ECE_ChargeArray.h"
+#include <cmath>
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__) && !defined(__AVX512F__)
+/**
+ * Adds the four lanes of an AVX register together.
+ *
+ * @param v     The register to reduce.
+ * @return      The sum of all lanes.
+ */
+static inline double horizontalSum(__m256d v) {
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+#endif
+
+constexpr double ECE_ChargeArray::k;
+
+void ECE_ChargeArray::reserve(std::size_t n) {
+    x.reserve(n);
+    y.reserve(n);
+    z.reserve(n);
+    q.reserve(n);
+}
+
+void ECE_ChargeArray::resize(std::size_t n) {
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    q.resize(n);
+}
+
+void ECE_ChargeArray::setCharge(std::size_t i, double x, double y, double z, double q) {
+    this->x[i] = x;
+    this->y[i] = y;
+    this->z[i] = z;
+    this->q[i] = q * 1.0e-6;
+}
+
+void ECE_ChargeArray::addCharge(double x, double y, double z, double q) {
+    this->x.push_back(x);
+    this->y.push_back(y);
+    this->z.push_back(z);
+    this->q.push_back(q * 1.0e-6);
+}
+
+void ECE_ChargeArray::computeFieldAt(double px, double py, double pz, std::size_t begin, std::size_t end,
+                                     double &Ex, double &Ey, double &Ez) const {
+    const double* xs = x.data();
+    const double* ys = y.data();
+    const double* zs = z.data();
+    const double* qs = q.data();
+
+    double sumEx = 0.0, sumEy = 0.0, sumEz = 0.0;
+    std::size_t i = begin;
+
+#if defined(__AVX512F__)
+    const __m512d vx = _mm512_set1_pd(px);
+    const __m512d vy = _mm512_set1_pd(py);
+    const __m512d vz = _mm512_set1_pd(pz);
+    __m512d accX = _mm512_setzero_pd();
+    __m512d accY = _mm512_setzero_pd();
+    __m512d accZ = _mm512_setzero_pd();
+
+    for (; i + 8 <= end; i += 8) {
+        __m512d dx = _mm512_sub_pd(vx, _mm512_loadu_pd(xs + i));
+        __m512d dy = _mm512_sub_pd(vy, _mm512_loadu_pd(ys + i));
+        __m512d dz = _mm512_sub_pd(vz, _mm512_loadu_pd(zs + i));
+
+        __m512d r_squared = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+        __m512d base_r = _mm512_mul_pd(_mm512_sqrt_pd(r_squared), r_squared);
+        __m512d scale = _mm512_div_pd(_mm512_loadu_pd(qs + i), base_r);
+
+        accX = _mm512_fmadd_pd(scale, dx, accX);
+        accY = _mm512_fmadd_pd(scale, dy, accY);
+        accZ = _mm512_fmadd_pd(scale, dz, accZ);
+    }
+    sumEx = _mm512_reduce_add_pd(accX);
+    sumEy = _mm512_reduce_add_pd(accY);
+    sumEz = _mm512_reduce_add_pd(accZ);
+#elif defined(__AVX2__) && defined(__FMA__)
+    const __m256d vx = _mm256_set1_pd(px);
+    const __m256d vy = _mm256_set1_pd(py);
+    const __m256d vz = _mm256_set1_pd(pz);
+    __m256d accX = _mm256_setzero_pd();
+    __m256d accY = _mm256_setzero_pd();
+    __m256d accZ = _mm256_setzero_pd();
+
+    for (; i + 4 <= end; i += 4) {
+        __m256d dx = _mm256_sub_pd(vx, _mm256_loadu_pd(xs + i));
+        __m256d dy = _mm256_sub_pd(vy, _mm256_loadu_pd(ys + i));
+        __m256d dz = _mm256_sub_pd(vz, _mm256_loadu_pd(zs + i));
+
+        __m256d r_squared = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+        __m256d base_r = _mm256_mul_pd(_mm256_sqrt_pd(r_squared), r_squared);
+        __m256d scale = _mm256_div_pd(_mm256_loadu_pd(qs + i), base_r);
+
+        accX = _mm256_fmadd_pd(scale, dx, accX);
+        accY = _mm256_fmadd_pd(scale, dy, accY);
+        accZ = _mm256_fmadd_pd(scale, dz, accZ);
+    }
+    sumEx = horizontalSum(accX);
+    sumEy = horizontalSum(accY);
+    sumEz = horizontalSum(accZ);
+#endif
+
+    for (; i < end; ++i) {
+        double dx = px - xs[i];
+        double dy = py - ys[i];
+        double dz = pz - zs[i];
+
+        double r_squared = dx * dx + dy * dy + dz * dz;
+        double scale = qs[i] / (sqrt(r_squared) * r_squared);
+
+        sumEx += scale * dx;
+        sumEy += scale * dy;
+        sumEz += scale * dz;
+    }
+
+    Ex = k * sumEx;
+    Ey = k * sumEy;
+    Ez = k * sumEz;
+}
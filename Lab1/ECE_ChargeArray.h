@@ -0,0 +1,129 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_ChargeArray class.
+This class stores a set of point charges as separate, cache-line aligned
+x, y, z and q arrays (structure of arrays) and sums their electric field
+at a point with an AVX2/AVX-512 kernel, keeping the partial sums in registers.
+
+*/
+
+#ifndef ECE_CHARGEARRAY_H
+#define ECE_CHARGEARRAY_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Allocator returning 64-byte aligned memory, so that every array starts
+ * on a cache line and a full AVX-512 register never straddles two lines.
+ * Elements are default-initialised instead of zeroed, so resize leaves the
+ * pages untouched and the threads filling an array place it on their own
+ * NUMA node by first touch.
+ */
+template <typename T>
+struct AlignedAllocator {
+    typedef T value_type;
+    static const std::size_t alignment = 64;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        std::size_t bytes = (n * sizeof(T) + alignment - 1) / alignment * alignment;
+        void* ptr = std::aligned_alloc(alignment, bytes);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+    void deallocate(T* ptr, std::size_t) { std::free(ptr); }
+
+    template <typename U>
+    void construct(U* ptr) noexcept { ::new (static_cast<void*>(ptr)) U; }
+    template <typename U, typename... Args>
+    void construct(U* ptr, Args&&... args) { ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+typedef std::vector<double, AlignedAllocator<double>> AlignedVector;
+
+class ECE_ChargeArray {
+protected:
+    AlignedVector x; // x-coordinates of the charges.
+    AlignedVector y; // y-coordinates of the charges.
+    AlignedVector z; // z-coordinates of the charges.
+    AlignedVector q; // charges in Coulomb.
+
+public:
+    static constexpr double k = 9.0e9; // Coulomb's constant N*m^2 /C^2
+
+    /**
+     * @brief Reserve storage for a number of charges.
+     *
+     * @param n The number of charges that will be added.
+     */
+    void reserve(std::size_t n);
+    /**
+     * @brief Resize the array to hold a number of charges, set later with setCharge.
+     *
+     * @param n The number of charges.
+     */
+    void resize(std::size_t n);
+    /**
+     * @brief Set the location and charge of an existing entry.
+     *
+     * @param i The index of the charge.
+     * @param x The x-coordinate of the point charge.
+     * @param y The y-coordinate of the point charge.
+     * @param z The z-coordinate of the point charge.
+     * @param q The charge of the point in micro Coulomb.
+     */
+    void setCharge(std::size_t i, double x, double y, double z, double q);
+    /**
+     * @brief Append a point charge to the array.
+     *
+     * @param x The x-coordinate of the point charge.
+     * @param y The y-coordinate of the point charge.
+     * @param z The z-coordinate of the point charge.
+     * @param q The charge of the point in micro Coulomb.
+     */
+    void addCharge(double x, double y, double z, double q);
+    /**
+     * @brief Get the number of charges stored.
+     */
+    std::size_t size() const { return q.size(); }
+    /**
+     * @brief Sum the electric field of the charges [begin, end) at a specified point.
+     *
+     * @param px The x-coordinate where the electric field is calculated.
+     * @param py The y-coordinate where the electric field is calculated.
+     * @param pz The z-coordinate where the electric field is calculated.
+     * @param begin Index of the first charge to include.
+     * @param end One past the index of the last charge to include.
+     * @param Ex Reference to store the electric field in the x-direction.
+     * @param Ey Reference to store the electric field in the y-direction.
+     * @param Ez Reference to store the electric field in the z-direction.
+     */
+    void computeFieldAt(double px, double py, double pz, std::size_t begin, std::size_t end,
+                        double &Ex, double &Ey, double &Ez) const;
+
+    // for testing
+    double getX(std::size_t i) const {return this->x[i];}
+    double getY(std::size_t i) const {return this->y[i];}
+    double getZ(std::size_t i) const {return this->z[i];}
+};
+
+#endif // ECE_CHARGEARRAY_H
@@ -0,0 +1,118 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_QueryProfiler class.
+This class records, for every thread of a field query, the time spent
+computing, the time spent waiting for the other threads, the number of
+charges processed and, where perf_event_open is allowed, the cycles,
+instructions and cache misses of the thread. After a query it
+prints one line per thread and an imbalance summary, which shows whether
+a query is limited by uneven work, by synchronization or by memory.
+
+The counters of a thread are opened by that thread on its first
+beginCompute and count only that thread, in user space. When they cannot
+be opened (in a virtual machine without a PMU, or with
+kernel.perf_event_paranoid above 2) the times are still recorded and the
+counters are reported as unavailable. When the kernel multiplexes more
+events than the PMU has counters, the counts are scaled by the share of
+the time the group was running, and a thread whose group never ran is
+reported as not counted.
+
+The cache-miss column is the generic PERF_COUNT_HW_CACHE_MISSES event,
+which the kernel maps to the closest miss count of the CPU; on most
+x86 parts it is the last-level cache, but that is not guaranteed.
+
+*/
+
+#ifndef ECE_QUERYPROFILER_H
+#define ECE_QUERYPROFILER_H
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+class ECE_QueryProfiler {
+protected:
+    /**
+     * @brief The measurements of one thread, padded to its own cache line.
+     */
+    struct alignas(64) ThreadSample {
+        double computeSeconds = 0.0;    // time between beginCompute and endCompute
+        double waitSeconds = 0.0;       // time reported with addWait
+        unsigned long charges = 0;      // charges processed
+        std::uint64_t cycles = 0;       // counter deltas over the compute time, scaled for multiplexing
+        std::uint64_t instructions = 0;
+        std::uint64_t cacheMisses = 0;
+        bool counted = true;            // false if the group never ran during a compute interval
+        int counterFd = -2;             // leader of the counter group, -2 before opening, -1 if unavailable
+        int memberFds[2] = {-1, -1};    // instructions and cache misses
+        double startTime = 0.0;         // time of the running beginCompute
+        std::uint64_t startCounts[5] = {0, 0, 0, 0, 0};
+    };
+
+    std::unique_ptr<ThreadSample[]> samples;
+    int numThreads;
+
+    void openCounters(ThreadSample& sample);
+    static bool readCounters(const ThreadSample& sample, std::uint64_t counts[5]);
+
+public:
+    /**
+     * @brief Constructor for ECE_QueryProfiler class.
+     *
+     * @param numThreads The number of threads taking part in a query.
+     */
+    explicit ECE_QueryProfiler(int numThreads);
+    /**
+     * @brief Closes the hardware counters.
+     */
+    ~ECE_QueryProfiler();
+
+    ECE_QueryProfiler(const ECE_QueryProfiler&) = delete;
+    ECE_QueryProfiler& operator=(const ECE_QueryProfiler&) = delete;
+
+    /**
+     * @brief Clear the measurements before a query.
+     */
+    void reset();
+    /**
+     * @brief Start timing the computation of a thread. Called by that thread.
+     *
+     * @param id The id of the thread.
+     */
+    void beginCompute(int id);
+    /**
+     * @brief Stop timing the computation of a thread. Called by that thread.
+     *
+     * @param id The id of the thread.
+     * @param charges The number of charges the thread processed.
+     */
+    void endCompute(int id, unsigned long charges);
+    /**
+     * @brief Add the time a thread waited for the others, e.g. at a barrier.
+     *
+     * @param id The id of the thread.
+     * @param seconds The waiting time in seconds.
+     */
+    void addWait(int id, double seconds);
+    /**
+     * @brief Print the measurements of every thread and the imbalance summary of the query.
+     *
+     * @param out The output stream.
+     */
+    void report(std::ostream& out) const;
+    /**
+     * @brief Get a monotonic time stamp in seconds.
+     */
+    static double now();
+    /**
+     * @brief Get the number of threads.
+     */
+    int getNumThreads() const { return numThreads; }
+};
+
+#endif // ECE_QUERYPROFILER_H
@@ -0,0 +1,119 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_ThreadPool and ECE_SpinBarrier classes.
+Spinning threads yield their core after a bounded number of polls, so an
+oversubscribed machine still makes progress.
+
+*/
+
+#include "ECE_ThreadPool.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CPU_RELAX() _mm_pause()
+#else
+#define CPU_RELAX() ((void)0)
+#endif
+
+ECE_SpinBarrier::ECE_SpinBarrier(int numThreads)
+    : remaining(numThreads), sense(false), numThreads(numThreads) {}
+
+void ECE_SpinBarrier::arriveAndWait(bool& localSense) {
+    localSense = !localSense;
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // Last arrival resets the count and releases the others
+        remaining.store(numThreads, std::memory_order_relaxed);
+        sense.store(localSense, std::memory_order_release);
+        return;
+    }
+    int polls = 0;
+    while (sense.load(std::memory_order_acquire) != localSense) {
+        if (++polls < 1000) {
+            CPU_RELAX();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+ECE_ThreadPool::ECE_ThreadPool(int numWorkers, const ECE_Affinity& affinity)
+    : workers(new Worker[numWorkers > 0 ? numWorkers : 1]), numWorkers(numWorkers > 0 ? numWorkers : 0),
+      generation(0), terminate(false), job(nullptr), done(this->numWorkers + 1), callerSense(false),
+      affinity(affinity), profiler(nullptr) {
+    this->affinity.pinThread(this->numWorkers);
+    threads.reserve(this->numWorkers);
+    for (int i = 0; i < this->numWorkers; ++i) {
+        threads.emplace_back(&ECE_ThreadPool::workerLoop, this, i);
+    }
+}
+
+ECE_ThreadPool::~ECE_ThreadPool() {
+    terminate.store(true);
+    generation.fetch_add(1);
+    for (int i = 0; i < numWorkers; ++i) {
+        std::lock_guard<std::mutex> lock(workers[i].mtx);
+        workers[i].cv.notify_one();
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+void ECE_ThreadPool::run(const std::function<void(int)>& job) {
+    this->job = &job;
+    // Publish the job; seq_cst pairs with the worker's parked/generation check
+    generation.fetch_add(1);
+    for (int i = 0; i < numWorkers; ++i) {
+        if (workers[i].parked.load()) {
+            std::lock_guard<std::mutex> lock(workers[i].mtx);
+            workers[i].cv.notify_one();
+        }
+    }
+
+    job(numWorkers);
+    arriveAndWait(numWorkers, callerSense);
+}
+
+void ECE_ThreadPool::arriveAndWait(int id, bool& sense) {
+    if (profiler == nullptr) {
+        done.arriveAndWait(sense);
+        return;
+    }
+    double start = ECE_QueryProfiler::now();
+    done.arriveAndWait(sense);
+    profiler->addWait(id, ECE_QueryProfiler::now() - start);
+}
+
+void ECE_ThreadPool::workerLoop(int id) {
+    Worker& self = workers[id];
+    unsigned seen = 0;
+    affinity.pinThread(id);
+
+    while (true) {
+        // Spin for a while, then park until the generation changes
+        int polls = 0;
+        while (generation.load(std::memory_order_acquire) == seen && polls < SPIN_COUNT) {
+            CPU_RELAX();
+            ++polls;
+        }
+        if (generation.load(std::memory_order_acquire) == seen) {
+            std::unique_lock<std::mutex> lock(self.mtx);
+            self.parked.store(true);
+            self.cv.wait(lock, [&] { return generation.load() != seen; });
+            self.parked.store(false);
+        }
+        seen = generation.load(std::memory_order_acquire);
+
+        if (terminate.load()) {
+            break;
+        }
+
+        (*job)(id);
+        arriveAndWait(id, self.barrierSense);
+    }
+}
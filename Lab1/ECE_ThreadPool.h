@@ -0,0 +1,118 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_ThreadPool class.
+This class keeps a set of worker threads alive between jobs. A job is
+published by bumping a generation counter that the workers spin on for a
+short while before parking on their own condition variable, and its
+completion is detected with a sense-reversing barrier, so a dispatch costs
+a few cache-line transfers instead of mutex-protected wakeups. With an
+affinity policy every worker and the calling thread are pinned to a CPU.
+With a profiler attached, the time every thread spends in the completion
+barrier is recorded as its waiting time.
+
+*/
+
+#ifndef ECE_THREADPOOL_H
+#define ECE_THREADPOOL_H
+
+#include "ECE_Affinity.h"
+#include "ECE_QueryProfiler.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Sense-reversing barrier for a fixed number of threads. Waiting
+ * threads spin on the shared sense flag, which is flipped by the last arrival.
+ */
+class ECE_SpinBarrier {
+protected:
+    alignas(64) std::atomic<int> remaining; // threads still to arrive in this phase
+    alignas(64) std::atomic<bool> sense;    // flipped when a phase completes
+    int numThreads;
+
+public:
+    /**
+     * @brief Constructor for ECE_SpinBarrier class.
+     *
+     * @param numThreads The number of threads taking part in every phase.
+     */
+    explicit ECE_SpinBarrier(int numThreads);
+    /**
+     * @brief Arrive at the barrier and wait until all threads have arrived.
+     *
+     * @param localSense The calling thread's sense, flipped on every call.
+     */
+    void arriveAndWait(bool& localSense);
+};
+
+class ECE_ThreadPool {
+protected:
+    /**
+     * @brief Per-worker parking state, padded to its own cache line.
+     */
+    struct alignas(64) Worker {
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::atomic<bool> parked{false};
+        bool barrierSense = false;
+    };
+
+    static const int SPIN_COUNT = 20000; // polls of the generation counter before parking
+
+    std::vector<std::thread> threads;
+    std::unique_ptr<Worker[]> workers;
+    int numWorkers;
+    alignas(64) std::atomic<unsigned> generation; // bumped once per published job
+    std::atomic<bool> terminate;
+    const std::function<void(int)>* job;          // the job of the current generation
+    ECE_SpinBarrier done;
+    bool callerSense;
+    ECE_Affinity affinity;                        // CPU of every thread id
+    ECE_QueryProfiler* profiler;                  // records the barrier waits, nullptr when off
+
+    void arriveAndWait(int id, bool& sense);
+
+    void workerLoop(int id);
+
+public:
+    /**
+     * @brief Constructor for ECE_ThreadPool class.
+     *
+     * @param numWorkers The number of worker threads, not counting the calling thread.
+     * @param affinity The pinning of the thread ids; the calling thread is pinned as id numWorkers.
+     */
+    explicit ECE_ThreadPool(int numWorkers, const ECE_Affinity& affinity = ECE_Affinity());
+    /**
+     * @brief Stops and joins all worker threads.
+     */
+    ~ECE_ThreadPool();
+    /**
+     * @brief Run a job on every worker and on the calling thread, and return when all are done.
+     * Workers receive the ids 0 .. numWorkers-1 and the calling thread the id numWorkers.
+     *
+     * @param job The function to run, called with the id of the executing thread.
+     */
+    void run(const std::function<void(int)>& job);
+    /**
+     * @brief Attach a profiler that records the time every thread waits at the end of a job.
+     *
+     * @param profiler The profiler, with at least getNumThreads() threads, or nullptr to stop recording.
+     */
+    void setProfiler(ECE_QueryProfiler* profiler) { this->profiler = profiler; }
+    /**
+     * @brief Get the number of threads taking part in a job, including the calling thread.
+     */
+    int getNumThreads() const { return numWorkers + 1; }
+};
+
+#endif // ECE_THREADPOOL_H
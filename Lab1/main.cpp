@@ -1,11 +1,14 @@
 // /*
 // Author:  Yang Gu
-// Date last modified: 25/9/2023
+// Date last modified: 17/10/2026
 // Organization: ECE6122 Class
 
 // Description:
 
 // Main function of Lab2
+// Usage: my_program [-P <none|compact|scatter|cpu list>] [-I] [-D]
+// -I prints the per-thread times, counters and load imbalance of every query
+// -D makes the field bit-identical for any thread count
     
 // */
 // #define TESTING_MODE // for testing
@@ -16,135 +19,97 @@
 #include <thread>
 #include <chrono>
 #include <iomanip>
-#include <condition_variable>
-#include <mutex>
-#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <memory>
 
 #include "utils.h"
 #include "ECE_ElectricField.h"
+#include "ECE_ChargeArray.h"
+#include "ECE_ThreadPool.h"
+#include "ECE_Affinity.h"
+#include "ECE_PairwiseSum.h"
+#include "ECE_QueryProfiler.h"
 
 using namespace std;
 
 const int MAX_THREADS = thread::hardware_concurrency();
-int activeThreads = 0;
+const unsigned long REDUCTION_BLOCK = 4096; // charges per block of the deterministic reduction
 
-mutex mtx;
-condition_variable cv;
+/**
+ * Per-thread partial field sums, each on its own cache line so that
+ * threads writing their results do not invalidate each other's line.
+ */
+struct alignas(64) PartialField {
+    double Ex = 0.0;
+    double Ey = 0.0;
+    double Ez = 0.0;
+};
 
-vector<ECE_ElectricField> vecElectric;
-vector<double> vecEx, vecEy, vecEz; 
+ECE_ChargeArray charges;
+vector<PartialField> partials;
+vector<double> blockFields; // Ex, Ey and Ez of every block in deterministic mode
 
 double x, y, z;
 
-bool breakloop = false;
-
-atomic<int> completedThreads(0);
-bool startFlag = false;
-bool terminateFlag = false;
-
 /**
- * Calculates the aggregated electric field at a specific point (x, y, z) for a segment of ECE_ElectricField objects.
- * The function is presumably designed to be run in main thread, which is responsible for a segment of the vector.
+ * Calculates the aggregated electric field at a specific point (x, y, z) for a segment of the charge array.
+ * This function is run by every thread of the pool for each query, where each thread is responsible for a segment of the array.
+ * The segments are balanced so that every charge is covered and their sizes differ by at most one.
  *
- * @param id              The ID representing the main thread. This determines the segment of the vector the function will operate on.
- * @param num_to_calculate The number of ECE_ElectricField objects each thread or task should calculate the electric field for.
- * @param max_num         The maximum index up to which the calculation should be performed in the vector. This prevents overrunning the end of the vector.
+ * @param id              The ID representing the current thread. This determines the segment of the array the function will operate on.
+ * @param num_threads     The number of threads sharing the calculation.
+ * @param max_num         The number of charges in the array.
  */
-void mainCalculateElectricField(const int id, const int num_to_calculate, const int max_num){
-    double tempEx(0.0), tempEy(0.0), tempEz(0.0);
+void CalculateElectricField(const int id, const int num_threads, const int max_num)
+{
     double sumEx(0.0), sumEy(0.0), sumEz(0.0);
-    unsigned long start_index = id * num_to_calculate;
-    unsigned long stop_index = max_num;
+    unsigned long start_index = (unsigned long)max_num * id / num_threads;
+    unsigned long stop_index = (unsigned long)max_num * (id + 1) / num_threads;
 
     if (stop_index > start_index){
-        for (int i = start_index; i < stop_index; ++i){
-            vecElectric[i].computeFieldAt(x, y, z);
-            vecElectric[i].getElectricField(tempEx, tempEy, tempEz);
-            sumEx += tempEx;
-            sumEy += tempEy;
-            sumEz += tempEz;
-        }
+        charges.computeFieldAt(x, y, z, start_index, stop_index, sumEx, sumEy, sumEz);
     }
-    vecEx[id] = sumEx;
-    vecEy[id] = sumEy;
-    vecEz[id] = sumEz;
-};
+    partials[id].Ex = sumEx;
+    partials[id].Ey = sumEy;
+    partials[id].Ez = sumEz;
+}
 
 /**
- * Calculates the aggregated electric field at a specific point (x, y, z) for a segment of ECE_ElectricField objects.
- * This function is designed to be run in parallel across multiple threads, where each thread is responsible for a segment of the vector.
- * Threads will wait until signalled by the main thread to start calculations and will notify the main thread upon completion.
+ * Deterministic variant of CalculateElectricField: the charges are cut into blocks of
+ * REDUCTION_BLOCK, independent of the thread count, and each thread stores the field of
+ * its blocks in blockFields, which are later summed pairwise in block order.
  *
- * @param id              The ID representing the current thread. This determines the segment of the vector the function will operate on.
- * @param num_to_calculate The number of ECE_ElectricField objects each thread should calculate the electric field for.
- * @param max_num         The maximum index up to which the calculation should be performed in the vector. This prevents overrunning the end of the vector.
+ * @param id              The ID representing the current thread.
+ * @param num_threads     The number of threads sharing the calculation.
+ * @param max_num         The number of charges in the array.
+ * @return                The number of charges summed by this thread.
  */
-void CalculateElectricField(const int id, const int num_to_calculate, const int max_num)
+unsigned long CalculateElectricFieldBlocks(const int id, const int num_threads, const int max_num)
 {
-    double tempEx(0.0), tempEy(0.0), tempEz(0.0);
-    double sumEx(0.0), sumEy(0.0), sumEz(0.0);
-    unsigned long start_index = id * num_to_calculate;
-    unsigned long stop_index = start_index + num_to_calculate;
-
-    if (stop_index > max_num)
-    {
-        stop_index = max_num;
-    }
-
-    while (true)    
-    {
-        // waiting to be signalled 
-        // the main thread should not wait
-        // main thread should break out
-        sumEx = 0.0;
-        sumEy = 0.0;
-        sumEz = 0.0;
-        {
-            unique_lock<mutex> lock(mtx);
-            cv.wait(lock, [] { return startFlag || terminateFlag; });
-        }
-        if (terminateFlag) {
-            break;
-        }
-        // Check if calculations should be started or if the thread should exit
-        // Check is signalled to exit
-        // 
-        // Do its part of the calculation
-        for (int i = start_index; i < stop_index; ++i){
-            vecElectric[i].computeFieldAt(x, y, z);
-            vecElectric[i].getElectricField(tempEx, tempEy, tempEz);
-            sumEx += tempEx;
-            sumEy += tempEy;
-            sumEz += tempEz;
-        }
-
-        vecEx[id] = sumEx;
-        vecEy[id] = sumEy;
-        vecEz[id] = sumEz;
-
-        // Signal that it is done with its part
-        completedThreads++;
-        if (completedThreads.load() == activeThreads ) {
-            cv.notify_all();  // Notify the main thread
-        }
-
-        // Wait for the main thread to finish its work before the next cycle
-        unique_lock<mutex> lock(mtx);
-        cv.wait(lock, [] { return !startFlag || terminateFlag; });
-        if (terminateFlag) {
-            break;
-        }
+    unsigned long num_blocks = ((unsigned long)max_num + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK;
+    unsigned long first_block = num_blocks * id / num_threads;
+    unsigned long last_block = num_blocks * (id + 1) / num_threads;
+    unsigned long count = 0;
+
+    for (unsigned long b = first_block; b < last_block; ++b) {
+        unsigned long start_index = b * REDUCTION_BLOCK;
+        unsigned long stop_index = min((unsigned long)max_num, start_index + REDUCTION_BLOCK);
+        charges.computeFieldAt(x, y, z, start_index, stop_index, blockFields[3 * b], blockFields[3 * b + 1],
+                               blockFields[3 * b + 2]);
+        count += stop_index - start_index;
     }
+    return count;
 }
 
 /**
  * Function for testing
- * Saves the electric field coordinates from a vector of ECE_ElectricField objects to a file.
+ * Saves the charge coordinates from an ECE_ChargeArray to a file.
  *
  * @param filename    The name of the file to which the coordinates will be saved.
- * @param vecElectricf The vector of ECE_ElectricField objects containing the coordinates.
+ * @param chargeArray The charge array containing the coordinates.
  */
-void saveCoordinatesToFile(const std::string& filename, vector<ECE_ElectricField>& vecElectricf) {
+void saveCoordinatesToFile(const std::string& filename, const ECE_ChargeArray& chargeArray) {
     std::ofstream outFile(filename);
 
     if (!outFile.is_open()) {
@@ -154,11 +119,11 @@ void saveCoordinatesToFile(const std::string& filename, vector<ECE_ElectricField
 
     outFile << "ID\tX\tY\tZ\n"; // Header for the file
 
-    for (size_t i = 0; i < vecElectricf.size(); ++i) {
+    for (size_t i = 0; i < chargeArray.size(); ++i) {
         outFile << i << "\t" 
-                << vecElectricf[i].getX() << "\t" 
-                << vecElectricf[i].getY() << "\t" 
-                << vecElectricf[i].getZ() << "\n";
+                << chargeArray.getX(i) << "\t" 
+                << chargeArray.getY(i) << "\t" 
+                << chargeArray.getZ(i) << "\n";
     }
 
     outFile.close();
@@ -166,7 +131,27 @@ void saveCoordinatesToFile(const std::string& filename, vector<ECE_ElectricField
 }
 
 
-int main() {
+int main(int argc, char* argv[]) {
+
+    // Optional thread pinning: -P <none|compact|scatter|cpu list>, per-thread instrumentation: -I,
+    // and sums that do not depend on the thread count: -D
+    ECE_Affinity affinity;
+    bool instrument = false;
+    bool deterministic = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+            if (!affinity.setPolicy(argv[++i])) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-I") == 0) {
+            instrument = true;
+        } else if (strcmp(argv[i], "-D") == 0) {
+            deterministic = true;
+        } else {
+            cerr << "Usage: " << argv[0] << " [-P <none|compact|scatter|cpu list>] [-I] [-D]" << endl;
+            return 1;
+        }
+    }
 
     cout << "Your computer supports " << MAX_THREADS << " concurrent threads." << endl;
     int rows, cols;
@@ -180,7 +165,6 @@ int main() {
         iss >> rows >>cols;
         iss >> xSeparation >> ySeparation;
         iss >> q;
-        saveCoordinatesToFile("coordinates.txt", vecElectric);
     #else
         // User input for array size, separation distances, charge, and point location
         getBasicInfo(q, rows, cols, xSeparation, ySeparation);
@@ -188,29 +172,38 @@ int main() {
 
     int max_num = cols*rows;
 
-    activeThreads = min(max_num, MAX_THREADS-1);
-    int num_per_thread = max_num/activeThreads;
-    vector<thread> vecThreads(activeThreads);
-
-    vecEx.resize(activeThreads+1);
-    vecEy.resize(activeThreads+1);
-    vecEz.resize(activeThreads+1);
+    // The main thread takes part in every query, so the pool needs one worker less
+    int numThreads = max(1, min(max_num, MAX_THREADS));
+    ECE_ThreadPool pool(numThreads - 1, affinity);
+    partials.resize(pool.getNumThreads());
+    const unsigned long num_blocks = ((unsigned long)max_num + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK;
+    if (deterministic) {
+        blockFields.resize(3 * num_blocks);
+    }
+    unique_ptr<ECE_QueryProfiler> profiler;
+    if (instrument) {
+        profiler.reset(new ECE_QueryProfiler(numThreads));
+        pool.setProfiler(profiler.get());
+    }
 
-    // create 2D charges array
+    // create 2D charges array; every thread writes the segment it sums later,
+    // so the first touch places the segment on that thread's NUMA node
     double halfRow = double(rows-1.0)/2.0;
     double halfCol = double(cols-1.0)/2.0;
-    for (double i = 0; i < rows; ++i) {
-        for (double j = 0; j < cols; ++j) {
-            double chargeX = (i-halfRow) * ySeparation;
-            double chargeY = (j-halfCol) * xSeparation;
-            vecElectric.push_back(ECE_ElectricField(chargeY, chargeX, 0, q));  // just a sample value
+    charges.resize(max_num);
+    pool.run([&](int id) {
+        unsigned long start_index = (unsigned long)max_num * id / numThreads;
+        unsigned long stop_index = (unsigned long)max_num * (id + 1) / numThreads;
+        for (unsigned long n = start_index; n < stop_index; ++n) {
+            double chargeX = (double(n % cols) - halfCol) * xSeparation;
+            double chargeY = (double(n / cols) - halfRow) * ySeparation;
+            charges.setCharge(n, chargeX, chargeY, 0, q);
         }
-    }
+    });
 
-    for (int i = 0; i < activeThreads; ++i)
-    {
-        vecThreads[i] = thread(CalculateElectricField, i, num_per_thread, max_num);
-    }
+    #ifdef TESTING_MODE
+        saveCoordinatesToFile("coordinates.txt", charges);
+    #endif
 
     while (true)
     {
@@ -228,42 +221,76 @@ int main() {
             getXYZ(x, y, z);
         #endif
 
-        //start
-        {
-            unique_lock<mutex> lock(mtx);
-            startFlag = true;
-            completedThreads.store(0);
-        }
         auto start_time = chrono::high_resolution_clock::now();
-        cv.notify_all();
 
-        int main_thread_num = activeThreads;
-        mainCalculateElectricField(main_thread_num, num_per_thread, max_num);
+        // every thread of the pool, the main thread included, sums its segment;
+        // in deterministic mode its blocks, which are then summed pairwise in block order
+        if (deterministic) {
+            if (profiler) {
+                profiler->reset();
+            }
+            pool.run([&](int id) {
+                if (profiler) {
+                    profiler->beginCompute(id);
+                }
+                unsigned long count = CalculateElectricFieldBlocks(id, numThreads, max_num);
+                if (profiler) {
+                    profiler->endCompute(id, count);
+                }
+            });
+            // Ex, Ey and Ez of the blocks combined by the pairwise tree of the batched queries
+            double total[3];
+            pairwiseBlockSum(0, size_t(num_blocks), 3, 0.0, total,
+                             [&](size_t b, double* out) {
+                                 for (int a = 0; a < 3; ++a) {
+                                     out[a] += blockFields[3 * b + a];
+                                 }
+                             },
+                             [](double& sum, double value) { sum += value; }, false);
+            Ex = total[0];
+            Ey = total[1];
+            Ez = total[2];
+        } else if (profiler) {
+            profiler->reset();
+            pool.run([&](int id) {
+                profiler->beginCompute(id);
+                CalculateElectricField(id, numThreads, max_num);
+                profiler->endCompute(id, (unsigned long)max_num * (id + 1) / numThreads
+                                         - (unsigned long)max_num * id / numThreads);
+            });
+        } else {
+            pool.run([&](int id) { CalculateElectricField(id, numThreads, max_num); });
+        }
 
-        //receive 
-        {
-            unique_lock<mutex> lock(mtx);
-            cv.wait(lock, [] { return completedThreads.load() == activeThreads; });
+        if (!deterministic) {
+            for (const PartialField& partial : partials) {
+                Ex += partial.Ex;
+                Ey += partial.Ey;
+                Ez += partial.Ez;
+            }
         }
 
         #ifdef TESTING_MODE
-            bool checkall =true;
-            for(auto point: vecElectric){
-                checkall = point.fieldComputed && checkall;
+            // compare against the per-object ECE_ElectricField path
+            double refEx(0.0), refEy(0.0), refEz(0.0), tempEx, tempEy, tempEz;
+            for (size_t i = 0; i < charges.size(); ++i){
+                ECE_ElectricField point(charges.getX(i), charges.getY(i), charges.getZ(i), q);
+                point.computeFieldAt(x, y, z);
+                point.getElectricField(tempEx, tempEy, tempEz);
+                refEx += tempEx;
+                refEy += tempEy;
+                refEz += tempEz;
             }
-            if (checkall){
+            double err = sqrt((Ex-refEx)*(Ex-refEx) + (Ey-refEy)*(Ey-refEy) + (Ez-refEz)*(Ez-refEz));
+            double refNorm = sqrt(refEx*refEx + refEy*refEy + refEz*refEz);
+            if (err <= 1e-12 * refNorm){
                 cout<<"All points have been computed\n";
             }
             else
             {
                 cerr<<"Error!\n";
             }
-            
         #endif
-
-        Ex = sum(vecEx);
-        Ey = sum(vecEy);
-        Ez = sum(vecEz);
         Enorm = sqrt(Ex * Ex + Ey * Ey + Ez * Ez);
         
         auto end_time = chrono::high_resolution_clock::now();
@@ -276,14 +303,11 @@ int main() {
             cout << "Ez = " << formatScientific(Ez) << "\n";
             cout << "|E| = " << formatScientific(Enorm) << "\n";
             cout << "The calculation took " << duration.count() << " microseconds!\n";
+            if (profiler) {
+                profiler->report(cout);
+            }
         }
 
-        {
-            unique_lock<mutex> lock(mtx);
-            startFlag = false;
-        }
-        cv.notify_all();
-
         #ifdef TESTING_MODE
             break;
         #else
@@ -295,15 +319,5 @@ int main() {
 
     }
 
-    {
-        unique_lock<mutex> lock(mtx);
-        terminateFlag = true;
-    }
-    cv.notify_all();
-
-    for (auto& t : vecThreads) {
-        t.join();
-    }
-
     return 0;
 }
@@ -13,6 +13,7 @@ Header file of the utilities functions.
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <cstddef>
 #include <vector>
 #include <string>
 
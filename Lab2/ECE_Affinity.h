@@ -0,0 +1,89 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_Affinity class.
+This class reads the NUMA topology of the machine from
+/sys/devices/system/node and maps thread ids to CPUs, so every thread can
+be pinned to one CPU. Pinned threads stay on the NUMA node where they
+first touched their slice of the charge arrays, so they keep reading
+local memory. The policies are:
+
+    none     threads are not pinned (the default)
+    compact  thread t on the t-th usable CPU, filling one node after another
+    scatter  threads dealt round-robin over the nodes, spreading the bandwidth
+    0,2,4-7  an explicit CPU list, thread t on the t-th listed CPU
+
+Only the CPUs the process may run on are used by compact and scatter.
+Without the sysfs topology the machine is treated as a single node.
+
+*/
+
+#ifndef ECE_AFFINITY_H
+#define ECE_AFFINITY_H
+
+#include <string>
+#include <vector>
+
+class ECE_Affinity {
+protected:
+    std::vector<int> cpus;      // CPU of each thread id, empty when threads are not pinned
+    std::vector<int> cpuNode;   // NUMA node of every CPU, indexed by CPU number
+    std::vector<bool> allowed;  // CPUs the process may run on, saved at construction
+    int numNodes;               // number of NUMA nodes with CPUs
+
+    static bool parseCpuList(const std::string& text, std::vector<int>& list);
+    bool isUsable(int cpu) const;
+    void readTopology();
+
+public:
+    /**
+     * @brief Constructor for ECE_Affinity class. Reads the topology; threads are not pinned.
+     */
+    ECE_Affinity();
+    /**
+     * @brief Select the pinning policy.
+     *
+     * @param spec "none", "compact", "scatter" or a CPU list such as "0,2,4-7".
+     * @return True if the policy is valid, false otherwise.
+     */
+    bool setPolicy(const std::string& spec);
+    /**
+     * @brief Check if threads are pinned.
+     */
+    bool isPinned() const { return !cpus.empty(); }
+    /**
+     * @brief Get the CPU of a thread id, wrapping around the CPU list; -1 when threads are not pinned.
+     */
+    int getCpu(int thread) const { return cpus.empty() ? -1 : cpus[thread % cpus.size()]; }
+    /**
+     * @brief Pin the calling thread to the CPU of a thread id. Does nothing when threads are not pinned.
+     *
+     * @param thread The thread id.
+     * @return True if the thread was pinned or pinning is off, false if the CPU was refused.
+     */
+    bool pinThread(int thread) const;
+    /**
+     * @brief Get the number of NUMA nodes.
+     */
+    int getNodeCount() const { return numNodes; }
+    /**
+     * @brief Get the NUMA node of a CPU, 0 when it is unknown.
+     */
+    int getNodeOfCpu(int cpu) const;
+    /**
+     * @brief Get the NUMA node the calling thread is running on.
+     */
+    int getCurrentNode() const;
+    /**
+     * @brief Get the NUMA node holding the page of an address, 0 when it is unknown.
+     *
+     * @param address An address inside a page that has been touched.
+     */
+    int getNodeOfAddress(const void* address) const;
+};
+
+#endif // ECE_AFFINITY_H
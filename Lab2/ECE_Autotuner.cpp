@@ -0,0 +1,197 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_Autotuner class.
+Each line of the configuration file holds
+    rows cols hardware_threads threads schedule chunk microseconds
+so one file can serve several lattice sizes and machines.
+
+*/
+
+#include "ECE_Autotuner.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+const std::size_t ECE_Autotuner::SCHEDULE_BLOCK;
+
+/**
+ * Converts an OpenMP schedule kind to its name.
+ *
+ * @param kind      The schedule kind.
+ * @return          "static", "dynamic", "guided" or "auto".
+ */
+static std::string scheduleName(omp_sched_t kind) {
+    switch (kind) {
+        case omp_sched_static: return "static";
+        case omp_sched_dynamic: return "dynamic";
+        case omp_sched_guided: return "guided";
+        default: return "auto";
+    }
+}
+
+/**
+ * Converts a schedule name back to the OpenMP schedule kind.
+ *
+ * @param name      The schedule name.
+ * @param kind      Reference to store the schedule kind.
+ * @return          True if the name is known, false otherwise.
+ */
+static bool scheduleFromName(const std::string& name, omp_sched_t& kind) {
+    if (name == "static") kind = omp_sched_static;
+    else if (name == "dynamic") kind = omp_sched_dynamic;
+    else if (name == "guided") kind = omp_sched_guided;
+    else if (name == "auto") kind = omp_sched_auto;
+    else return false;
+    return true;
+}
+
+ECE_Autotuner::ECE_Autotuner(const std::string& filename, int repetitions)
+    : filename(filename), repetitions(repetitions < 1 ? 1 : repetitions) {}
+
+void ECE_Autotuner::computeField(const ECE_ChargeArray& charges, double x, double y, double z,
+                                 double &Ex, double &Ey, double &Ez) {
+    const std::size_t n = charges.size();
+    const long numBlocks = long((n + SCHEDULE_BLOCK - 1) / SCHEDULE_BLOCK);
+    double sumEx = 0.0, sumEy = 0.0, sumEz = 0.0;
+
+    #pragma omp parallel for schedule(runtime) reduction(+:sumEx, sumEy, sumEz)
+    for (long b = 0; b < numBlocks; ++b) {
+        double tempEx, tempEy, tempEz;
+        std::size_t begin = b * SCHEDULE_BLOCK;
+        std::size_t end = std::min(n, begin + SCHEDULE_BLOCK);
+        charges.computeFieldAt(x, y, z, begin, end, tempEx, tempEy, tempEz);
+        sumEx += tempEx;
+        sumEy += tempEy;
+        sumEz += tempEz;
+    }
+
+    Ex = sumEx;
+    Ey = sumEy;
+    Ez = sumEz;
+}
+
+std::string ECE_Autotuner::describe(const TuningConfig& config) {
+    std::ostringstream oss;
+    oss << config.threads << " threads, schedule(" << scheduleName(config.schedule);
+    if (config.chunk > 0) {
+        oss << ", " << config.chunk;
+    }
+    oss << ")";
+    return oss.str();
+}
+
+double ECE_Autotuner::measure(const ECE_ChargeArray& charges, const TuningConfig& config) const {
+    omp_set_num_threads(config.threads);
+    omp_set_schedule(config.schedule, config.chunk);
+
+    double Ex, Ey, Ez;
+    std::vector<double> times(repetitions);
+    computeField(charges, 1.0, 2.0, 3.0, Ex, Ey, Ez); // warm-up: spawns the threads and loads the caches
+    for (int r = 0; r < repetitions; ++r) {
+        double start_time = omp_get_wtime();
+        computeField(charges, 1.0, 2.0, 3.0, Ex, Ey, Ez);
+        times[r] = (omp_get_wtime() - start_time) * 1e6;
+    }
+    std::nth_element(times.begin(), times.begin() + repetitions / 2, times.end());
+    return times[repetitions / 2];
+}
+
+TuningConfig ECE_Autotuner::tune(const ECE_ChargeArray& charges, int maxThreads) const {
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(std::max(1, maxThreads));
+
+    // chunk 0 with a static schedule is the balanced contiguous split
+    std::vector<std::pair<omp_sched_t, int>> schedules = {{omp_sched_static, 0}};
+    for (int chunk : {1, 4, 16, 64}) {
+        schedules.push_back({omp_sched_static, chunk});
+        schedules.push_back({omp_sched_dynamic, chunk});
+        schedules.push_back({omp_sched_guided, chunk});
+    }
+
+    TuningConfig best;
+    best.microseconds = -1.0;
+    for (int threads : threadCounts) {
+        for (const auto& schedule : schedules) {
+            TuningConfig candidate;
+            candidate.threads = threads;
+            candidate.schedule = schedule.first;
+            candidate.chunk = schedule.second;
+            candidate.microseconds = measure(charges, candidate);
+            std::cout << "  " << describe(candidate) << ": " << candidate.microseconds << " microseconds\n";
+            if (best.microseconds < 0.0 || candidate.microseconds < best.microseconds) {
+                best = candidate;
+            }
+        }
+    }
+    return best;
+}
+
+bool ECE_Autotuner::load(int rows, int cols, TuningConfig& config) const {
+    std::ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        return false;
+    }
+
+    const int hardwareThreads = omp_get_num_procs();
+    std::string line;
+    while (std::getline(inFile, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream stream(line);
+        int r, c, hw;
+        std::string name;
+        TuningConfig entry;
+        if (stream >> r >> c >> hw >> entry.threads >> name >> entry.chunk >> entry.microseconds
+            && scheduleFromName(name, entry.schedule)
+            && r == rows && c == cols && hw == hardwareThreads && entry.threads > 0) {
+            config = entry;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ECE_Autotuner::save(int rows, int cols, const TuningConfig& config) const {
+    const int hardwareThreads = omp_get_num_procs();
+    std::vector<std::string> kept;
+
+    // Keep the entries of other lattice sizes and machines
+    std::ifstream inFile(filename);
+    std::string line;
+    while (std::getline(inFile, line)) {
+        std::istringstream stream(line);
+        int r, c, hw;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (stream >> r >> c >> hw && r == rows && c == cols && hw == hardwareThreads) {
+            continue;
+        }
+        kept.push_back(line);
+    }
+    inFile.close();
+
+    std::ofstream outFile(filename);
+    if (!outFile.is_open()) {
+        std::cerr << "Error: Unable to open file for writing: " << filename << std::endl;
+        return false;
+    }
+    outFile << "# rows cols hardware_threads threads schedule chunk microseconds\n";
+    for (const std::string& entry : kept) {
+        outFile << entry << "\n";
+    }
+    outFile << rows << " " << cols << " " << hardwareThreads << " " << config.threads << " "
+            << scheduleName(config.schedule) << " " << config.chunk << " " << config.microseconds << "\n";
+    return bool(outFile);
+}
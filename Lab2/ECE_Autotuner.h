@@ -0,0 +1,95 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_Autotuner class.
+This class benchmarks thread counts, OpenMP schedules and chunk sizes for
+the field query on the current machine and lattice size, and stores the
+fastest configuration in a text file so the next run can reuse it.
+
+*/
+
+#ifndef ECE_AUTOTUNER_H
+#define ECE_AUTOTUNER_H
+
+#include "ECE_ChargeArray.h"
+#include <omp.h>
+#include <string>
+
+/**
+ * @brief A thread count and OpenMP loop schedule for the field query.
+ */
+struct TuningConfig {
+    int threads = 1;
+    omp_sched_t schedule = omp_sched_static;
+    int chunk = 0;              // in blocks of SCHEDULE_BLOCK charges, 0 = balanced static split
+    double microseconds = 0.0;  // median query time measured when tuning
+};
+
+class ECE_Autotuner {
+protected:
+    std::string filename;   // file holding one tuned configuration per lattice size
+    int repetitions;        // timed queries per candidate configuration
+
+    double measure(const ECE_ChargeArray& charges, const TuningConfig& config) const;
+
+public:
+    static const std::size_t SCHEDULE_BLOCK = 1024; // charges per loop iteration of the query
+
+    /**
+     * @brief Constructor for ECE_Autotuner class.
+     *
+     * @param filename The file the tuned configurations are loaded from and saved to.
+     * @param repetitions The number of timed queries per candidate configuration.
+     */
+    ECE_Autotuner(const std::string& filename, int repetitions = 7);
+    /**
+     * @brief Look up the configuration stored for a lattice size on this machine.
+     *
+     * @param rows The number of rows of the lattice.
+     * @param cols The number of columns of the lattice.
+     * @param config Reference to store the configuration.
+     * @return True if a configuration was found, false otherwise.
+     */
+    bool load(int rows, int cols, TuningConfig& config) const;
+    /**
+     * @brief Store the configuration for a lattice size, replacing any previous entry.
+     *
+     * @param rows The number of rows of the lattice.
+     * @param cols The number of columns of the lattice.
+     * @param config The configuration to store.
+     * @return True if the file was written, false otherwise.
+     */
+    bool save(int rows, int cols, const TuningConfig& config) const;
+    /**
+     * @brief Benchmark the candidate configurations and return the fastest one.
+     *
+     * @param charges The charges the query runs over.
+     * @param maxThreads The largest thread count to try.
+     * @return The configuration with the lowest median query time.
+     */
+    TuningConfig tune(const ECE_ChargeArray& charges, int maxThreads) const;
+
+    /**
+     * @brief Sum the field of all charges at a point with the current thread count and runtime schedule.
+     *
+     * @param charges The charges to sum.
+     * @param x The x-coordinate where the electric field is calculated.
+     * @param y The y-coordinate where the electric field is calculated.
+     * @param z The z-coordinate where the electric field is calculated.
+     * @param Ex Reference to store the electric field in the x-direction.
+     * @param Ey Reference to store the electric field in the y-direction.
+     * @param Ez Reference to store the electric field in the z-direction.
+     */
+    static void computeField(const ECE_ChargeArray& charges, double x, double y, double z,
+                             double &Ex, double &Ey, double &Ez);
+    /**
+     * @brief Format a configuration as text, e.g. "8 threads, schedule(dynamic, 4)".
+     */
+    static std::string describe(const TuningConfig& config);
+};
+
+#endif // ECE_AUTOTUNER_H
@@ -0,0 +1,654 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_ChargeArray class.
+The field kernel is selected at compile time: AVX-512 (8 charges per step),
+AVX2 + FMA (4 charges per step), or a scalar loop. The remainder of a range
+that does not fill a register is always handled by the scalar loop.
+Batched queries load each group of charges once and accumulate it into
+several points at the same time.
+The single-precision kernel has the same structure with twice as many
+lanes; its float accumulators are reduced into double after every
+SINGLE_BLOCK charges.
+Arrays declared a lattice with setLattice use the kernels of
+ECE_LatticeKernel.h for double-precision queries instead.
+
+*/
+
+#include "ECE_ChargeArray.h"
+#include "ECE_ChargeFile.h"
+#include "ECE_LatticeKernel.h"
+#include "ECE_PairwiseSum.h"
+#include "ECE_SimdMath.h"
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX512F__)
+static const int POINT_BLOCK = 4; // 4 points x 3 accumulators fit in the 32 zmm registers
+#else
+static const int POINT_BLOCK = 2; // 2 points x 3 accumulators fit in the 16 ymm registers
+#endif
+
+/**
+ * Adds the field of the charges [begin, end) at P points to out, without the Coulomb constant.
+ * Each group of charges is loaded once and reused for all P points.
+ *
+ * @param xs, ys, zs, qs    The charge arrays.
+ * @param begin             Index of the first charge to include.
+ * @param end               One past the index of the last charge to include.
+ * @param pts               The P query points.
+ * @param out               The P fields to accumulate into.
+ */
+template <int P>
+static inline void accumulateBlock(const double* xs, const double* ys, const double* zs, const double* qs,
+                                   std::size_t begin, std::size_t end, const Point* pts, Field* out) {
+    double sumEx[P], sumEy[P], sumEz[P];
+    for (int p = 0; p < P; ++p) {
+        sumEx[p] = 0.0;
+        sumEy[p] = 0.0;
+        sumEz[p] = 0.0;
+    }
+    std::size_t i = begin;
+
+#if defined(__AVX512F__)
+    __m512d accX[P], accY[P], accZ[P];
+    for (int p = 0; p < P; ++p) {
+        accX[p] = _mm512_setzero_pd();
+        accY[p] = _mm512_setzero_pd();
+        accZ[p] = _mm512_setzero_pd();
+    }
+
+    for (; i + 8 <= end; i += 8) {
+        const __m512d cx = _mm512_loadu_pd(xs + i);
+        const __m512d cy = _mm512_loadu_pd(ys + i);
+        const __m512d cz = _mm512_loadu_pd(zs + i);
+        const __m512d cq = _mm512_loadu_pd(qs + i);
+        for (int p = 0; p < P; ++p) {
+            __m512d dx = _mm512_sub_pd(_mm512_set1_pd(pts[p].x), cx);
+            __m512d dy = _mm512_sub_pd(_mm512_set1_pd(pts[p].y), cy);
+            __m512d dz = _mm512_sub_pd(_mm512_set1_pd(pts[p].z), cz);
+
+            __m512d r_squared = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+            __m512d inv_r = reciprocalSqrt(r_squared);
+            __m512d scale = _mm512_mul_pd(cq, _mm512_mul_pd(inv_r, _mm512_mul_pd(inv_r, inv_r)));
+
+            accX[p] = _mm512_fmadd_pd(scale, dx, accX[p]);
+            accY[p] = _mm512_fmadd_pd(scale, dy, accY[p]);
+            accZ[p] = _mm512_fmadd_pd(scale, dz, accZ[p]);
+        }
+    }
+    for (int p = 0; p < P; ++p) {
+        sumEx[p] = _mm512_reduce_add_pd(accX[p]);
+        sumEy[p] = _mm512_reduce_add_pd(accY[p]);
+        sumEz[p] = _mm512_reduce_add_pd(accZ[p]);
+    }
+#elif defined(__AVX2__) && defined(__FMA__)
+    __m256d accX[P], accY[P], accZ[P];
+    for (int p = 0; p < P; ++p) {
+        accX[p] = _mm256_setzero_pd();
+        accY[p] = _mm256_setzero_pd();
+        accZ[p] = _mm256_setzero_pd();
+    }
+
+    for (; i + 4 <= end; i += 4) {
+        const __m256d cx = _mm256_loadu_pd(xs + i);
+        const __m256d cy = _mm256_loadu_pd(ys + i);
+        const __m256d cz = _mm256_loadu_pd(zs + i);
+        const __m256d cq = _mm256_loadu_pd(qs + i);
+        for (int p = 0; p < P; ++p) {
+            __m256d dx = _mm256_sub_pd(_mm256_set1_pd(pts[p].x), cx);
+            __m256d dy = _mm256_sub_pd(_mm256_set1_pd(pts[p].y), cy);
+            __m256d dz = _mm256_sub_pd(_mm256_set1_pd(pts[p].z), cz);
+
+            __m256d r_squared = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+            __m256d base_r = _mm256_mul_pd(_mm256_sqrt_pd(r_squared), r_squared);
+            __m256d scale = _mm256_div_pd(cq, base_r);
+
+            accX[p] = _mm256_fmadd_pd(scale, dx, accX[p]);
+            accY[p] = _mm256_fmadd_pd(scale, dy, accY[p]);
+            accZ[p] = _mm256_fmadd_pd(scale, dz, accZ[p]);
+        }
+    }
+    for (int p = 0; p < P; ++p) {
+        sumEx[p] = horizontalSum(accX[p]);
+        sumEy[p] = horizontalSum(accY[p]);
+        sumEz[p] = horizontalSum(accZ[p]);
+    }
+#endif
+
+    for (; i < end; ++i) {
+        for (int p = 0; p < P; ++p) {
+            double dx = pts[p].x - xs[i];
+            double dy = pts[p].y - ys[i];
+            double dz = pts[p].z - zs[i];
+
+            double r_squared = dx * dx + dy * dy + dz * dz;
+            double scale = qs[i] / (sqrt(r_squared) * r_squared);
+
+            sumEx[p] += scale * dx;
+            sumEy[p] += scale * dy;
+            sumEz[p] += scale * dz;
+        }
+    }
+
+    for (int p = 0; p < P; ++p) {
+        out[p].Ex += sumEx[p];
+        out[p].Ey += sumEy[p];
+        out[p].Ez += sumEz[p];
+    }
+}
+
+/**
+ * Adds the field of the charges [begin, end) at m points to out, POINT_BLOCK points at a time.
+ *
+ * @param xs, ys, zs, qs    The charge arrays.
+ * @param begin             Index of the first charge to include.
+ * @param end               One past the index of the last charge to include.
+ * @param pts               The query points.
+ * @param m                 The number of query points.
+ * @param out               The m fields to accumulate into.
+ */
+static void accumulateTile(const double* xs, const double* ys, const double* zs, const double* qs,
+                           std::size_t begin, std::size_t end, const Point* pts, std::size_t m, Field* out) {
+    std::size_t p = 0;
+    for (; p + POINT_BLOCK <= m; p += POINT_BLOCK) {
+        accumulateBlock<POINT_BLOCK>(xs, ys, zs, qs, begin, end, pts + p, out + p);
+    }
+    for (; p < m; ++p) {
+        accumulateBlock<1>(xs, ys, zs, qs, begin, end, pts + p, out + p);
+    }
+}
+
+/**
+ * Single-precision version of accumulateBlock. The float accumulators only ever
+ * hold SINGLE_BLOCK charges before they are added to the double sums.
+ *
+ * @param xs, ys, zs, qs    The float charge arrays.
+ * @param begin             Index of the first charge to include.
+ * @param end               One past the index of the last charge to include.
+ * @param pts               The P query points.
+ * @param out               The P fields to accumulate into.
+ */
+template <int P>
+static inline void accumulateBlockSingle(const float* xs, const float* ys, const float* zs, const float* qs,
+                                         std::size_t begin, std::size_t end, const Point* pts, Field* out) {
+    double sumEx[P], sumEy[P], sumEz[P];
+    float px[P], py[P], pz[P];
+    for (int p = 0; p < P; ++p) {
+        sumEx[p] = 0.0;
+        sumEy[p] = 0.0;
+        sumEz[p] = 0.0;
+        px[p] = float(pts[p].x);
+        py[p] = float(pts[p].y);
+        pz[p] = float(pts[p].z);
+    }
+    std::size_t i = begin;
+
+#if defined(__AVX512F__)
+    while (i + 16 <= end) {
+        const std::size_t blockEnd = std::min(end, i + ECE_ChargeArray::SINGLE_BLOCK);
+        __m512 accX[P], accY[P], accZ[P];
+        for (int p = 0; p < P; ++p) {
+            accX[p] = _mm512_setzero_ps();
+            accY[p] = _mm512_setzero_ps();
+            accZ[p] = _mm512_setzero_ps();
+        }
+
+        for (; i + 16 <= blockEnd; i += 16) {
+            const __m512 cx = _mm512_loadu_ps(xs + i);
+            const __m512 cy = _mm512_loadu_ps(ys + i);
+            const __m512 cz = _mm512_loadu_ps(zs + i);
+            const __m512 cq = _mm512_loadu_ps(qs + i);
+            for (int p = 0; p < P; ++p) {
+                __m512 dx = _mm512_sub_ps(_mm512_set1_ps(px[p]), cx);
+                __m512 dy = _mm512_sub_ps(_mm512_set1_ps(py[p]), cy);
+                __m512 dz = _mm512_sub_ps(_mm512_set1_ps(pz[p]), cz);
+
+                __m512 r_squared = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dz, dz)));
+                __m512 inv_r = reciprocalSqrt(r_squared);
+                __m512 scale = _mm512_mul_ps(cq, _mm512_mul_ps(inv_r, _mm512_mul_ps(inv_r, inv_r)));
+
+                accX[p] = _mm512_fmadd_ps(scale, dx, accX[p]);
+                accY[p] = _mm512_fmadd_ps(scale, dy, accY[p]);
+                accZ[p] = _mm512_fmadd_ps(scale, dz, accZ[p]);
+            }
+        }
+        for (int p = 0; p < P; ++p) {
+            sumEx[p] += horizontalSumToDouble(accX[p]);
+            sumEy[p] += horizontalSumToDouble(accY[p]);
+            sumEz[p] += horizontalSumToDouble(accZ[p]);
+        }
+    }
+#elif defined(__AVX2__) && defined(__FMA__)
+    while (i + 8 <= end) {
+        const std::size_t blockEnd = std::min(end, i + ECE_ChargeArray::SINGLE_BLOCK);
+        __m256 accX[P], accY[P], accZ[P];
+        for (int p = 0; p < P; ++p) {
+            accX[p] = _mm256_setzero_ps();
+            accY[p] = _mm256_setzero_ps();
+            accZ[p] = _mm256_setzero_ps();
+        }
+
+        for (; i + 8 <= blockEnd; i += 8) {
+            const __m256 cx = _mm256_loadu_ps(xs + i);
+            const __m256 cy = _mm256_loadu_ps(ys + i);
+            const __m256 cz = _mm256_loadu_ps(zs + i);
+            const __m256 cq = _mm256_loadu_ps(qs + i);
+            for (int p = 0; p < P; ++p) {
+                __m256 dx = _mm256_sub_ps(_mm256_set1_ps(px[p]), cx);
+                __m256 dy = _mm256_sub_ps(_mm256_set1_ps(py[p]), cy);
+                __m256 dz = _mm256_sub_ps(_mm256_set1_ps(pz[p]), cz);
+
+                __m256 r_squared = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+                __m256 inv_r = reciprocalSqrt(r_squared);
+                __m256 scale = _mm256_mul_ps(cq, _mm256_mul_ps(inv_r, _mm256_mul_ps(inv_r, inv_r)));
+
+                accX[p] = _mm256_fmadd_ps(scale, dx, accX[p]);
+                accY[p] = _mm256_fmadd_ps(scale, dy, accY[p]);
+                accZ[p] = _mm256_fmadd_ps(scale, dz, accZ[p]);
+            }
+        }
+        for (int p = 0; p < P; ++p) {
+            sumEx[p] += horizontalSumToDouble(accX[p]);
+            sumEy[p] += horizontalSumToDouble(accY[p]);
+            sumEz[p] += horizontalSumToDouble(accZ[p]);
+        }
+    }
+#endif
+
+    for (; i < end; ++i) {
+        for (int p = 0; p < P; ++p) {
+            float dx = px[p] - xs[i];
+            float dy = py[p] - ys[i];
+            float dz = pz[p] - zs[i];
+
+            float r_squared = dx * dx + dy * dy + dz * dz;
+            float scale = qs[i] / (std::sqrt(r_squared) * r_squared);
+
+            sumEx[p] += scale * dx;
+            sumEy[p] += scale * dy;
+            sumEz[p] += scale * dz;
+        }
+    }
+
+    for (int p = 0; p < P; ++p) {
+        out[p].Ex += sumEx[p];
+        out[p].Ey += sumEy[p];
+        out[p].Ez += sumEz[p];
+    }
+}
+
+/**
+ * Single-precision version of accumulateTile.
+ *
+ * @param xs, ys, zs, qs    The float charge arrays.
+ * @param begin             Index of the first charge to include.
+ * @param end               One past the index of the last charge to include.
+ * @param pts               The query points.
+ * @param m                 The number of query points.
+ * @param out               The m fields to accumulate into.
+ */
+static void accumulateTileSingle(const float* xs, const float* ys, const float* zs, const float* qs,
+                                 std::size_t begin, std::size_t end, const Point* pts, std::size_t m, Field* out) {
+    std::size_t p = 0;
+    for (; p + POINT_BLOCK <= m; p += POINT_BLOCK) {
+        accumulateBlockSingle<POINT_BLOCK>(xs, ys, zs, qs, begin, end, pts + p, out + p);
+    }
+    for (; p < m; ++p) {
+        accumulateBlockSingle<1>(xs, ys, zs, qs, begin, end, pts + p, out + p);
+    }
+}
+
+constexpr double ECE_ChargeArray::k;
+const std::size_t ECE_ChargeArray::CHARGE_TILE;
+const std::size_t ECE_ChargeArray::POINT_TILE;
+const std::size_t ECE_ChargeArray::SINGLE_BLOCK;
+
+void ECE_ChargeArray::materialize() {
+    if (!mapping) {
+        return;
+    }
+    x.assign(mapped[0], mapped[0] + mappedCount);
+    y.assign(mapped[1], mapped[1] + mappedCount);
+    z.assign(mapped[2], mapped[2] + mappedCount);
+    q.assign(mapped[3], mapped[3] + mappedCount);
+    mapping.reset();
+}
+
+bool ECE_ChargeArray::mapFile(const std::string& filename, std::size_t first, std::size_t last) {
+    std::shared_ptr<ECE_ChargeFile> file(new ECE_ChargeFile(filename));
+    if (!file->isOpen()) {
+        return false;
+    }
+    last = std::min(last, file->size());
+    first = std::min(first, last);
+    file->willNeed(first, last);
+
+    AlignedVector().swap(x);
+    AlignedVector().swap(y);
+    AlignedVector().swap(z);
+    AlignedVector().swap(q);
+    for (int axis = 0; axis < 4; ++axis) {
+        mapped[axis] = file->getArray(axis) + first;
+    }
+    mappedCount = last - first;
+    mapping = file;
+    clearLattice();
+    if (singlePrecision) {
+        setSinglePrecision(true);
+    }
+    return true;
+}
+
+bool ECE_ChargeArray::saveFile(const std::string& filename) const {
+    const std::size_t n = size();
+    ECE_ChargeFile file(filename, n);
+    if (!file.isOpen()) {
+        return false;
+    }
+    const double* arrays[4] = {xData(), yData(), zData(), qData()};
+    for (int axis = 0; axis < 4; ++axis) {
+        std::memcpy(file.getWritableArray(axis), arrays[axis], n * sizeof(double));
+    }
+    return true;
+}
+
+void ECE_ChargeArray::reserve(std::size_t n) {
+    materialize();
+    x.reserve(n);
+    y.reserve(n);
+    z.reserve(n);
+    q.reserve(n);
+}
+
+void ECE_ChargeArray::resize(std::size_t n) {
+    materialize();
+    if (lattice.rows != 0) {
+        clearLattice();
+    }
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    q.resize(n);
+    if (singlePrecision) {
+        xf.resize(n);
+        yf.resize(n);
+        zf.resize(n);
+        qf.resize(n);
+    }
+}
+
+void ECE_ChargeArray::setCharge(std::size_t i, double x, double y, double z, double q) {
+    materialize();
+    if (lattice.rows != 0) {
+        clearLattice();
+    }
+    this->x[i] = x;
+    this->y[i] = y;
+    this->z[i] = z;
+    this->q[i] = q * 1.0e-6;
+    if (singlePrecision) {
+        xf[i] = float(this->x[i]);
+        yf[i] = float(this->y[i]);
+        zf[i] = float(this->z[i]);
+        qf[i] = float(this->q[i]);
+    }
+}
+
+void ECE_ChargeArray::setPosition(std::size_t i, double x, double y, double z) {
+    materialize();
+    if (lattice.rows != 0) {
+        clearLattice();
+    }
+    this->x[i] = x;
+    this->y[i] = y;
+    this->z[i] = z;
+    if (singlePrecision) {
+        xf[i] = float(x);
+        yf[i] = float(y);
+        zf[i] = float(z);
+    }
+}
+
+void ECE_ChargeArray::copyCharge(std::size_t i, const ECE_ChargeArray& other, std::size_t j) {
+    materialize();
+    if (lattice.rows != 0) {
+        clearLattice();
+    }
+    this->x[i] = other.getX(j);
+    this->y[i] = other.getY(j);
+    this->z[i] = other.getZ(j);
+    this->q[i] = other.getQ(j);
+    if (singlePrecision) {
+        xf[i] = float(this->x[i]);
+        yf[i] = float(this->y[i]);
+        zf[i] = float(this->z[i]);
+        qf[i] = float(this->q[i]);
+    }
+}
+
+void ECE_ChargeArray::addCharge(double x, double y, double z, double q) {
+    materialize();
+    if (lattice.rows != 0) {
+        clearLattice();
+    }
+    this->x.push_back(x);
+    this->y.push_back(y);
+    this->z.push_back(z);
+    this->q.push_back(q * 1.0e-6);
+    if (singlePrecision) {
+        xf.push_back(float(this->x.back()));
+        yf.push_back(float(this->y.back()));
+        zf.push_back(float(this->z.back()));
+        qf.push_back(float(this->q.back()));
+    }
+}
+
+bool ECE_ChargeArray::setLattice(std::size_t rows, std::size_t cols, double x0, double y0, double xSeparation,
+                                 double ySeparation) {
+    clearLattice();
+    const std::size_t n = size();
+    if (rows == 0 || cols == 0 || rows * cols != n) {
+        return false;
+    }
+    const double* xs = xData();
+    const double* ys = yData();
+    const double* zs = zData();
+    const double* qs = qData();
+    // Positions written as j * xSeparation - halfCol may differ from x0 + j * xSeparation in the last bits
+    const double tolerance = 1e-12 * (std::fabs(x0) + std::fabs(y0) + cols * std::fabs(xSeparation)
+                                      + rows * std::fabs(ySeparation));
+    long misplaced = 0, otherZ = 0, otherQ = 0;
+    #pragma omp parallel for schedule(static) reduction(+:misplaced, otherZ, otherQ)
+    for (long i = 0; i < long(n); ++i) {
+        const std::size_t row = std::size_t(i) / cols, col = std::size_t(i) % cols;
+        misplaced += std::fabs(xs[i] - (x0 + col * xSeparation)) > tolerance
+                     || std::fabs(ys[i] - (y0 + row * ySeparation)) > tolerance;
+        otherZ += zs[i] != zs[0];
+        otherQ += qs[i] != qs[0];
+    }
+    if (misplaced > 0) {
+        return false;
+    }
+
+    lattice.rows = rows;
+    lattice.cols = cols;
+    lattice.x0 = x0;
+    lattice.y0 = y0;
+    lattice.xSeparation = xSeparation;
+    lattice.ySeparation = ySeparation;
+    lattice.uniformQ = otherQ == 0;
+    lattice.planar = otherZ == 0;
+    lattice.q = qs[0];
+    lattice.z = zs[0];
+    return true;
+}
+
+void ECE_ChargeArray::setSinglePrecision(bool enable) {
+    singlePrecision = enable;
+    if (!enable) {
+        AlignedFloatVector().swap(xf);
+        AlignedFloatVector().swap(yf);
+        AlignedFloatVector().swap(zf);
+        AlignedFloatVector().swap(qf);
+        return;
+    }
+    const std::size_t n = size();
+    xf.resize(n);
+    yf.resize(n);
+    zf.resize(n);
+    qf.resize(n);
+    const double* xs = xData();
+    const double* ys = yData();
+    const double* zs = zData();
+    const double* qs = qData();
+    // Same static split as the kernels, so every thread first-touches the floats it reads
+    #pragma omp parallel for schedule(static)
+    for (std::size_t i = 0; i < n; ++i) {
+        xf[i] = float(xs[i]);
+        yf[i] = float(ys[i]);
+        zf[i] = float(zs[i]);
+        qf[i] = float(qs[i]);
+    }
+}
+
+void ECE_ChargeArray::computeFieldAt(double px, double py, double pz, std::size_t begin, std::size_t end,
+                                     double &Ex, double &Ey, double &Ez) const {
+    Point pt = {px, py, pz};
+    Field sum = {0.0, 0.0, 0.0};
+
+    if (singlePrecision) {
+        accumulateBlockSingle<1>(xf.data(), yf.data(), zf.data(), qf.data(), begin, end, &pt, &sum);
+    } else if (lattice.rows != 0) {
+        accumulateLatticeTile(lattice, zData(), qData(), begin, end, &pt, 1, &sum);
+    } else {
+        accumulateBlock<1>(xData(), yData(), zData(), qData(), begin, end, &pt, &sum);
+    }
+
+    Ex = k * sum.Ex;
+    Ey = k * sum.Ey;
+    Ez = k * sum.Ez;
+}
+
+void ECE_ChargeArray::evaluateField(const Point* pts, std::size_t m, Field* out) const {
+    evaluateFieldWith(singlePrecision, pts, m, out);
+}
+
+double ECE_ChargeArray::measureSinglePrecisionError(const Point* pts, std::size_t m) const {
+    if (!singlePrecision) {
+        return 0.0;
+    }
+    std::vector<Field> reference(m), approximate(m);
+    evaluateFieldWith(false, pts, m, reference.data());
+    evaluateFieldWith(true, pts, m, approximate.data());
+
+    double maxError = 0.0;
+    for (std::size_t p = 0; p < m; ++p) {
+        double dEx = approximate[p].Ex - reference[p].Ex;
+        double dEy = approximate[p].Ey - reference[p].Ey;
+        double dEz = approximate[p].Ez - reference[p].Ez;
+        double norm = std::sqrt(reference[p].Ex * reference[p].Ex + reference[p].Ey * reference[p].Ey
+                                + reference[p].Ez * reference[p].Ez);
+        if (norm > 0.0) {
+            maxError = std::max(maxError, std::sqrt(dEx * dEx + dEy * dEy + dEz * dEz) / norm);
+        }
+    }
+    return maxError;
+}
+
+void ECE_ChargeArray::evaluateFieldWith(bool single, const Point* pts, std::size_t m, Field* out) const {
+    const std::size_t n = size();
+    if (!single && lattice.rows != 0) {
+        evaluateLatticeField(lattice, zData(), qData(), n, pts, m, out, deterministic);
+        return;
+    }
+    const long numPointTiles = (m + POINT_TILE - 1) / POINT_TILE;
+    const int maxThreads = omp_get_max_threads();
+    auto accumulate = [&](std::size_t c0, std::size_t c1, const Point* tilePts, std::size_t tileM, Field* tileOut) {
+        if (single) {
+            accumulateTileSingle(xf.data(), yf.data(), zf.data(), qf.data(), c0, c1, tilePts, tileM, tileOut);
+        } else {
+            accumulateTile(xData(), yData(), zData(), qData(), c0, c1, tilePts, tileM, tileOut);
+        }
+    };
+    const Field zero = {0.0, 0.0, 0.0};
+    auto add = [](Field& a, const Field& b) {
+        a.Ex += b.Ex;
+        a.Ey += b.Ey;
+        a.Ez += b.Ez;
+    };
+
+    for (std::size_t p = 0; p < m; ++p) {
+        out[p].Ex = 0.0;
+        out[p].Ey = 0.0;
+        out[p].Ez = 0.0;
+    }
+
+    if (deterministic && n > 0) {
+        // One task per point tile, and the large subtrees of its tree as further tasks
+        const std::size_t numChargeTiles = (n + CHARGE_TILE - 1) / CHARGE_TILE;
+        #pragma omp parallel
+        #pragma omp single
+        for (long t = 0; t < numPointTiles; ++t) {
+            std::size_t p0 = t * POINT_TILE;
+            std::size_t p1 = std::min(m, p0 + POINT_TILE);
+            auto sumChargeTile = [&, p0, p1](std::size_t c, Field* tileOut) {
+                accumulate(c * CHARGE_TILE, std::min(n, (c + 1) * CHARGE_TILE), pts + p0, p1 - p0, tileOut);
+            };
+            #pragma omp task firstprivate(p0, p1, sumChargeTile)
+            pairwiseBlockSum(0, numChargeTiles, p1 - p0, zero, out + p0, sumChargeTile, add, true);
+        }
+    } else if (numPointTiles >= maxThreads) {
+        // Enough points: each thread owns whole point tiles and sweeps all charge tiles over them
+        #pragma omp parallel for schedule(dynamic)
+        for (long t = 0; t < numPointTiles; ++t) {
+            std::size_t p0 = t * POINT_TILE;
+            std::size_t p1 = std::min(m, p0 + POINT_TILE);
+            for (std::size_t c0 = 0; c0 < n; c0 += CHARGE_TILE) {
+                std::size_t c1 = std::min(n, c0 + CHARGE_TILE);
+                accumulate(c0, c1, pts + p0, p1 - p0, out + p0);
+            }
+        }
+    } else {
+        // Few points: split the charges over the threads and merge private results in thread order
+        std::vector<Field> partial(std::size_t(maxThreads) * m, Field{0.0, 0.0, 0.0});
+        #pragma omp parallel
+        {
+            int id = omp_get_thread_num();
+            int numThreads = omp_get_num_threads();
+            std::size_t begin = n * id / numThreads;
+            std::size_t end = n * (id + 1) / numThreads;
+            Field* mine = &partial[std::size_t(id) * m];
+            for (std::size_t c0 = begin; c0 < end; c0 += CHARGE_TILE) {
+                std::size_t c1 = std::min(end, c0 + CHARGE_TILE);
+                for (std::size_t p0 = 0; p0 < m; p0 += POINT_TILE) {
+                    std::size_t p1 = std::min(m, p0 + POINT_TILE);
+                    accumulate(c0, c1, pts + p0, p1 - p0, mine + p0);
+                }
+            }
+        }
+        for (int id = 0; id < maxThreads; ++id) {
+            for (std::size_t p = 0; p < m; ++p) {
+                out[p].Ex += partial[std::size_t(id) * m + p].Ex;
+                out[p].Ey += partial[std::size_t(id) * m + p].Ey;
+                out[p].Ez += partial[std::size_t(id) * m + p].Ez;
+            }
+        }
+    }
+
+    for (std::size_t p = 0; p < m; ++p) {
+        out[p].Ex *= k;
+        out[p].Ey *= k;
+        out[p].Ez *= k;
+    }
+}
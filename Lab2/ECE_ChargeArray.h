@@ -0,0 +1,321 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_ChargeArray class.
+This class stores a set of point charges as separate, cache-line aligned
+x, y, z and q arrays (structure of arrays) and sums their electric field
+at a point with an AVX2/AVX-512 kernel, keeping the partial sums in registers.
+An opt-in single-precision mode keeps a float copy of the arrays and runs a
+kernel twice as wide, flushing its float partial sums into double every
+SINGLE_BLOCK charges so the error does not grow with the number of charges.
+The arrays can also be a read-only view of a memory-mapped charge-set file
+(ECE_ChargeFile); the first edit of a mapped array copies it into memory.
+
+*/
+
+#ifndef ECE_CHARGEARRAY_H
+#define ECE_CHARGEARRAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+class ECE_ChargeFile;
+
+/**
+ * @brief Allocator returning 64-byte aligned memory, so that every array starts
+ * on a cache line and a full AVX-512 register never straddles two lines.
+ * Arrays of 2 MB and more are aligned to 2 MB and advised for transparent
+ * huge pages, which cuts the TLB misses of sweeping large charge sets.
+ * Elements are default-initialised instead of zeroed, so resize leaves the
+ * pages untouched and the threads filling an array place it on their own
+ * NUMA node by first touch.
+ */
+template <typename T>
+struct AlignedAllocator {
+    typedef T value_type;
+    static const std::size_t alignment = 64;
+    static const std::size_t hugePage = std::size_t(2) << 20;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        const std::size_t align = n * sizeof(T) >= hugePage ? hugePage : alignment;
+        std::size_t bytes = (n * sizeof(T) + align - 1) / align * align;
+        void* ptr = std::aligned_alloc(align, bytes);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (align == hugePage) {
+            madvise(ptr, bytes, MADV_HUGEPAGE);
+        }
+#endif
+        return static_cast<T*>(ptr);
+    }
+    void deallocate(T* ptr, std::size_t) { std::free(ptr); }
+
+    template <typename U>
+    void construct(U* ptr) noexcept { ::new (static_cast<void*>(ptr)) U; }
+    template <typename U, typename... Args>
+    void construct(U* ptr, Args&&... args) { ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+typedef std::vector<double, AlignedAllocator<double>> AlignedVector;
+typedef std::vector<float, AlignedAllocator<float>> AlignedFloatVector;
+
+/**
+ * @brief A location in space where the electric field is evaluated.
+ */
+struct Point {
+    double x;
+    double y;
+    double z;
+};
+
+/**
+ * @brief The electric field components at a query point in V/m.
+ */
+struct Field {
+    double Ex;
+    double Ey;
+    double Ez;
+};
+
+/**
+ * @brief Geometry of charges on a regular lattice: charge n sits in row n / cols
+ * and column n % cols, at (x0 + column * xSeparation, y0 + row * ySeparation).
+ */
+struct LatticeGeometry {
+    std::size_t rows = 0;       // 0 when the charges are not a lattice
+    std::size_t cols = 0;
+    double x0 = 0.0;            // position of the charge in row 0, column 0
+    double y0 = 0.0;
+    double xSeparation = 0.0;
+    double ySeparation = 0.0;
+    bool uniformQ = false;      // every charge has the charge q
+    bool planar = false;        // every charge has the height z
+    double q = 0.0;             // in Coulomb
+    double z = 0.0;
+};
+
+class ECE_ChargeArray {
+protected:
+    AlignedVector x; // x-coordinates of the charges.
+    AlignedVector y; // y-coordinates of the charges.
+    AlignedVector z; // z-coordinates of the charges.
+    AlignedVector q; // charges in Coulomb.
+
+    bool singlePrecision = false; // queries use the float copy below
+    AlignedFloatVector xf;        // float copy of x, y, z and q, kept only in single-precision mode
+    AlignedFloatVector yf;
+    AlignedFloatVector zf;
+    AlignedFloatVector qf;
+
+    std::shared_ptr<const ECE_ChargeFile> mapping; // mapped charge-set file, empty when the vectors hold the charges
+    const double* mapped[4] = {nullptr, nullptr, nullptr, nullptr}; // x, y, z and q inside the mapping
+    std::size_t mappedCount = 0;
+
+    LatticeGeometry lattice;      // set by setLattice, cleared by any edit of the charges
+    bool deterministic = false;   // batched queries reduce fixed charge tiles pairwise (ECE_PairwiseSum.h)
+
+    void materialize();
+    void evaluateFieldWith(bool single, const Point* pts, std::size_t m, Field* out) const;
+
+public:
+    static constexpr double k = 9.0e9; // Coulomb's constant N*m^2 /C^2
+    static const std::size_t CHARGE_TILE = 4096; // charges per tile, 128 KB of x/y/z/q stays in L2
+    static const std::size_t POINT_TILE = 64;    // query points accumulated against each charge tile
+    static const std::size_t SINGLE_BLOCK = 1024; // charges summed in float before flushing into double
+
+    /**
+     * @brief Reserve storage for a number of charges.
+     *
+     * @param n The number of charges that will be added.
+     */
+    void reserve(std::size_t n);
+    /**
+     * @brief Resize the array to hold a number of charges, set later with setCharge.
+     *
+     * @param n The number of charges.
+     */
+    void resize(std::size_t n);
+    /**
+     * @brief Set the location and charge of an existing entry.
+     *
+     * @param i The index of the charge.
+     * @param x The x-coordinate of the point charge.
+     * @param y The y-coordinate of the point charge.
+     * @param z The z-coordinate of the point charge.
+     * @param q The charge of the point in micro Coulomb.
+     */
+    void setCharge(std::size_t i, double x, double y, double z, double q);
+    /**
+     * @brief Move an existing charge, keeping its value.
+     *
+     * @param i The index of the charge.
+     * @param x The new x-coordinate.
+     * @param y The new y-coordinate.
+     * @param z The new z-coordinate.
+     */
+    void setPosition(std::size_t i, double x, double y, double z);
+    /**
+     * @brief Copy an entry of another array into this one, without unit conversion.
+     *
+     * @param i The index of the entry to overwrite.
+     * @param other The array to copy from.
+     * @param j The index of the entry in the other array.
+     */
+    void copyCharge(std::size_t i, const ECE_ChargeArray& other, std::size_t j);
+    /**
+     * @brief Append a point charge to the array.
+     *
+     * @param x The x-coordinate of the point charge.
+     * @param y The y-coordinate of the point charge.
+     * @param z The z-coordinate of the point charge.
+     * @param q The charge of the point in micro Coulomb.
+     */
+    void addCharge(double x, double y, double z, double q);
+    /**
+     * @brief Get the number of charges stored.
+     */
+    std::size_t size() const { return mapping ? mappedCount : q.size(); }
+    /**
+     * @brief Use the charges [first, last) of a charge-set file, mapped instead of read.
+     * Any charges held before are dropped.
+     *
+     * @param filename The charge-set file written by saveFile or convert_charges.
+     * @param first Index of the first charge to use.
+     * @param last One past the index of the last charge to use, clamped to the file.
+     * @return True if the file was mapped, false otherwise.
+     */
+    bool mapFile(const std::string& filename, std::size_t first = 0, std::size_t last = SIZE_MAX);
+    /**
+     * @brief Write the charges to a charge-set file.
+     *
+     * @param filename The file to create.
+     * @return True if the file was written, false otherwise.
+     */
+    bool saveFile(const std::string& filename) const;
+    /**
+     * @brief Check if the charges are a view of a mapped file.
+     */
+    bool isMapped() const { return bool(mapping); }
+    /**
+     * @brief Sum the electric field of the charges [begin, end) at a specified point.
+     *
+     * @param px The x-coordinate where the electric field is calculated.
+     * @param py The y-coordinate where the electric field is calculated.
+     * @param pz The z-coordinate where the electric field is calculated.
+     * @param begin Index of the first charge to include.
+     * @param end One past the index of the last charge to include.
+     * @param Ex Reference to store the electric field in the x-direction.
+     * @param Ey Reference to store the electric field in the y-direction.
+     * @param Ez Reference to store the electric field in the z-direction.
+     */
+    void computeFieldAt(double px, double py, double pz, std::size_t begin, std::size_t end,
+                        double &Ex, double &Ey, double &Ez) const;
+    /**
+     * @brief Evaluate the electric field of all charges at a batch of points.
+     * Charges are processed in tiles of CHARGE_TILE that stay in cache while
+     * POINT_TILE points are accumulated against them; the work is split over
+     * the OpenMP threads by point tile, or by charge range when there are
+     * too few points to keep every thread busy. In deterministic mode both
+     * splits add the charge tiles with the same pairwise tree instead.
+     *
+     * @param pts The query points.
+     * @param m The number of query points.
+     * @param out Array of m entries receiving the field at each point.
+     */
+    void evaluateField(const Point* pts, std::size_t m, Field* out) const;
+    /**
+     * @brief Declare that the charges form a regular lattice, so the double-precision
+     * queries generate x and y from the indices (ECE_LatticeKernel.h) instead of
+     * reading them. The charges are checked against the geometry, and a common q
+     * and z are detected; any later edit of the charges drops the lattice.
+     *
+     * @param rows The number of rows.
+     * @param cols The number of columns; rows * cols must be the number of charges.
+     * @param x0 The x-coordinate of the charge in row 0, column 0.
+     * @param y0 The y-coordinate of the charge in row 0, column 0.
+     * @param xSeparation The distance between columns.
+     * @param ySeparation The distance between rows.
+     * @return True if the charges match the lattice, false otherwise (the generic kernel stays in use).
+     */
+    bool setLattice(std::size_t rows, std::size_t cols, double x0, double y0, double xSeparation,
+                    double ySeparation);
+    /**
+     * @brief Go back to the generic kernel.
+     */
+    void clearLattice() { lattice = LatticeGeometry(); }
+    /**
+     * @brief Get the lattice geometry; rows is 0 when the charges are not a lattice.
+     */
+    const LatticeGeometry& getLattice() const { return lattice; }
+    /**
+     * @brief Switch the queries between the double and the single-precision kernel.
+     * Enabling builds the float copy of the charges, which later edits keep up to date;
+     * disabling releases it.
+     *
+     * @param enable True for the single-precision kernel, false for double.
+     */
+    void setSinglePrecision(bool enable);
+    /**
+     * @brief Check if the queries use the single-precision kernel.
+     */
+    bool isSinglePrecision() const { return singlePrecision; }
+    /**
+     * @brief Make the batched queries bit-identical for any number of threads.
+     * Every charge tile is summed on its own and the tile sums are added with a
+     * fixed pairwise tree, in both the point-tile and the charge-range split.
+     *
+     * @param enable True for the reproducible reduction, false for the default one.
+     */
+    void setDeterministic(bool enable) { deterministic = enable; }
+    /**
+     * @brief Check if the batched queries use the reproducible reduction.
+     */
+    bool isDeterministic() const { return deterministic; }
+    /**
+     * @brief Measure the error of the single-precision kernel against the double one.
+     * Both kernels are run over the points; single precision must be enabled.
+     *
+     * @param pts The probe points.
+     * @param m The number of probe points.
+     * @return The largest |E_single - E_double| / |E_double| over the points, 0 when disabled.
+     */
+    double measureSinglePrecisionError(const Point* pts, std::size_t m) const;
+
+    // raw arrays, for kernels outside this class (q in Coulomb)
+    const double* xData() const { return mapping ? mapped[0] : x.data(); }
+    const double* yData() const { return mapping ? mapped[1] : y.data(); }
+    const double* zData() const { return mapping ? mapped[2] : z.data(); }
+    const double* qData() const { return mapping ? mapped[3] : q.data(); }
+
+    // for testing
+    double getX(std::size_t i) const {return xData()[i];}
+    double getY(std::size_t i) const {return yData()[i];}
+    double getZ(std::size_t i) const {return zData()[i];}
+    double getQ(std::size_t i) const {return qData()[i];} // in Coulomb
+};
+
+#endif // ECE_CHARGEARRAY_H
@@ -0,0 +1,143 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_ChargeDynamics class.
+The potential energy is only needed for the energy report, so the kernel
+computes the potential next to the field on those steps alone.
+
+*/
+
+#include "ECE_ChargeDynamics.h"
+#include <cstdint>
+#include <iostream>
+#include <omp.h>
+
+ECE_ChargeDynamics::ECE_ChargeDynamics(const ECE_ChargeArray& initial, double mass, double softening)
+    : mass(mass), softening(softening), time(0.0), stepCount(0), potentialEnergy(0.0), pairInteractions(0),
+      forceSeconds(0.0) {
+    const std::size_t n = initial.size();
+    charges.resize(n);
+    vx.assign(n, 0.0);
+    vy.assign(n, 0.0);
+    vz.assign(n, 0.0);
+    ax.resize(n);
+    ay.resize(n);
+    az.resize(n);
+    positions.resize(n);
+    terms.resize(n);
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < long(n); ++i) {
+        charges.copyCharge(i, initial, i);
+    }
+    computeAccelerations(true);
+}
+
+void ECE_ChargeDynamics::computeAccelerations(bool withEnergy) {
+    const std::size_t n = charges.size();
+    const double* xs = charges.xData();
+    const double* ys = charges.yData();
+    const double* zs = charges.zData();
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < long(n); ++i) {
+        positions[i] = Point{xs[i], ys[i], zs[i]};
+    }
+
+    double start_time = omp_get_wtime();
+    if (withEnergy) {
+        evaluateTerms<OUTPUT_POTENTIAL | OUTPUT_FIELD>(charges, positions.data(), n, terms.data(), softening);
+    } else {
+        evaluateTerms<OUTPUT_FIELD>(charges, positions.data(), n, terms.data(), softening);
+    }
+    forceSeconds += omp_get_wtime() - start_time;
+    pairInteractions += (unsigned long long)n * n;
+
+    // a = q E / m; the softened self term adds k q / eps to V and nothing to E
+    const double* qs = charges.qData();
+    double energy = 0.0;
+    #pragma omp parallel for schedule(static) reduction(+:energy)
+    for (long i = 0; i < long(n); ++i) {
+        const double qm = qs[i] / mass;
+        ax[i] = qm * terms[i].Ex;
+        ay[i] = qm * terms[i].Ey;
+        az[i] = qm * terms[i].Ez;
+        if (withEnergy) {
+            energy += 0.5 * qs[i] * (terms[i].V - ECE_ChargeArray::k * qs[i] / softening);
+        }
+    }
+    if (withEnergy) {
+        potentialEnergy = energy;
+    }
+}
+
+void ECE_ChargeDynamics::setVelocity(std::size_t i, double vx, double vy, double vz) {
+    this->vx[i] = vx;
+    this->vy[i] = vy;
+    this->vz[i] = vz;
+}
+
+void ECE_ChargeDynamics::step(double dt, bool withEnergy) {
+    const std::size_t n = charges.size();
+    const double* xs = charges.xData();
+    const double* ys = charges.yData();
+    const double* zs = charges.zData();
+
+    // Half kick and drift
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < long(n); ++i) {
+        vx[i] += 0.5 * dt * ax[i];
+        vy[i] += 0.5 * dt * ay[i];
+        vz[i] += 0.5 * dt * az[i];
+        charges.setPosition(i, xs[i] + dt * vx[i], ys[i] + dt * vy[i], zs[i] + dt * vz[i]);
+    }
+
+    // Forces at the new positions and the second half kick
+    computeAccelerations(withEnergy);
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < long(n); ++i) {
+        vx[i] += 0.5 * dt * ax[i];
+        vy[i] += 0.5 * dt * ay[i];
+        vz[i] += 0.5 * dt * az[i];
+    }
+    time += dt;
+    ++stepCount;
+}
+
+double ECE_ChargeDynamics::getKineticEnergy() const {
+    const std::size_t n = charges.size();
+    double energy = 0.0;
+    #pragma omp parallel for schedule(static) reduction(+:energy)
+    for (long i = 0; i < long(n); ++i) {
+        energy += vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i];
+    }
+    return 0.5 * mass * energy;
+}
+
+bool ECE_ChargeDynamics::openCheckpoints(const std::string& filename) {
+    checkpointFile.open(filename, std::ios::binary | std::ios::trunc);
+    if (!checkpointFile.is_open()) {
+        std::cerr << "Error: Unable to open file for writing: " << filename << std::endl;
+        return false;
+    }
+    const uint64_t n = charges.size();
+    checkpointFile.write("ECENBODY", 8);
+    checkpointFile.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    checkpointFile.write(reinterpret_cast<const char*>(charges.qData()), n * sizeof(double));
+    return bool(checkpointFile);
+}
+
+bool ECE_ChargeDynamics::writeCheckpoint() {
+    const std::size_t n = charges.size();
+    const uint64_t step = stepCount;
+    checkpointFile.write(reinterpret_cast<const char*>(&step), sizeof(step));
+    checkpointFile.write(reinterpret_cast<const char*>(&time), sizeof(time));
+    const double* arrays[6] = {charges.xData(), charges.yData(), charges.zData(), vx.data(), vy.data(), vz.data()};
+    for (const double* array : arrays) {
+        checkpointFile.write(reinterpret_cast<const char*>(array), n * sizeof(double));
+    }
+    checkpointFile.flush();
+    return bool(checkpointFile);
+}
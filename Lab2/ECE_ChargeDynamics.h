@@ -0,0 +1,118 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_ChargeDynamics class.
+This class moves free point charges of equal mass under their mutual
+Coulomb forces with the velocity-Verlet integrator:
+    v += a dt / 2,  r += v dt,  a = q E(r) / m,  v += a dt / 2.
+The fields come from the tiled all-pairs kernel of ECE_FieldTerms.h, run
+with every charge as a query point and shared out over the OpenMP
+threads. Plummer softening eps (r^2 -> r^2 + eps^2) bounds the force of
+close encounters and removes the self term, so it must be positive.
+
+Checkpoints append frames to one binary file, which holds the whole
+trajectory and every state needed to restart from a frame:
+
+    char[8]         magic "ECENBODY"
+    uint64          number of charges n
+    double[n]       q in Coulomb
+    then per frame:
+    uint64          step
+    double          time in seconds
+    double[6 n]     x, y, z, vx, vy, vz (one array after another)
+
+*/
+
+#ifndef ECE_CHARGEDYNAMICS_H
+#define ECE_CHARGEDYNAMICS_H
+
+#include "ECE_ChargeArray.h"
+#include "ECE_FieldTerms.h"
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class ECE_ChargeDynamics {
+protected:
+    ECE_ChargeArray charges;            // positions and charges, in memory
+    AlignedVector vx, vy, vz;           // velocities in m/s
+    AlignedVector ax, ay, az;           // accelerations in m/s^2 at the current positions
+    double mass;                        // mass of every charge in kg
+    double softening;                   // softening length eps in meters
+    double time;                        // simulated time in seconds
+    unsigned long long stepCount;
+    double potentialEnergy;             // at the last force evaluation with energy
+    unsigned long long pairInteractions;
+    double forceSeconds;                // time spent in the force kernel
+    std::vector<Point> positions;       // query points of the force kernel
+    std::vector<FieldTerms> terms;      // fields (and potentials) at the charges
+    std::ofstream checkpointFile;
+
+    void computeAccelerations(bool withEnergy);
+
+public:
+    /**
+     * @brief Constructor for ECE_ChargeDynamics class. The charges start at rest.
+     *
+     * @param initial The initial positions and charges, copied.
+     * @param mass The mass of every charge in kg.
+     * @param softening The softening length eps in meters, positive.
+     */
+    ECE_ChargeDynamics(const ECE_ChargeArray& initial, double mass, double softening);
+    /**
+     * @brief Set the velocity of a charge.
+     *
+     * @param i The index of the charge.
+     * @param vx The velocity in the x-direction.
+     * @param vy The velocity in the y-direction.
+     * @param vz The velocity in the z-direction.
+     */
+    void setVelocity(std::size_t i, double vx, double vy, double vz);
+    /**
+     * @brief Advance all charges by one velocity-Verlet step.
+     *
+     * @param dt The time step in seconds.
+     * @param withEnergy True to also compute the potential energy at the new positions.
+     */
+    void step(double dt, bool withEnergy = false);
+    /**
+     * @brief Get the kinetic energy in J.
+     */
+    double getKineticEnergy() const;
+    /**
+     * @brief Get the softened potential energy in J at the last step computed with energy.
+     */
+    double getPotentialEnergy() const { return potentialEnergy; }
+    /**
+     * @brief Open a checkpoint file and write its header.
+     *
+     * @param filename The file, replaced if it exists.
+     * @return True if the file was opened, false otherwise.
+     */
+    bool openCheckpoints(const std::string& filename);
+    /**
+     * @brief Append the current positions and velocities as a frame.
+     *
+     * @return True if the frame was written, false otherwise.
+     */
+    bool writeCheckpoint();
+
+    const ECE_ChargeArray& getCharges() const { return charges; }
+    double getTime() const { return time; }
+    unsigned long long getStepCount() const { return stepCount; }
+    /**
+     * @brief Get the number of charge pairs evaluated by the force kernel so far.
+     */
+    unsigned long long getPairInteractions() const { return pairInteractions; }
+    /**
+     * @brief Get the time spent in the force kernel so far, in seconds.
+     */
+    double getForceSeconds() const { return forceSeconds; }
+};
+
+#endif // ECE_CHARGEDYNAMICS_H
@@ -0,0 +1,187 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_ChargeFile class.
+The mapping is advised for transparent huge pages where the kernel
+supports it, and read-ahead is requested only for the charges in use, so
+a rank mapping one slice of a large file does not pull in the rest.
+
+*/
+
+#include "ECE_ChargeFile.h"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char CHARGE_FILE_MAGIC[8] = {'E', 'C', 'E', 'C', 'H', 'G', '0', '1'};
+
+/**
+ * The mapped region of a charge-set file, unmapped when it is destroyed.
+ */
+struct ECE_ChargeFile::Mapping {
+    void* address;
+    std::size_t length;
+
+    Mapping(void* address, std::size_t length) : address(address), length(length) {}
+    ~Mapping() { munmap(address, length); }
+    char* bytes() const { return static_cast<char*>(address); }
+
+    /**
+     * Maps the first bytes of an open file, advised for transparent huge pages.
+     *
+     * @param fd        The open file.
+     * @param bytes     The number of bytes to map.
+     * @param writable  True for a shared writable mapping, false for a read-only one.
+     * @return          The mapping, or nullptr if mmap failed.
+     */
+    static Mapping* map(int fd, std::size_t bytes, bool writable) {
+        void* ptr = mmap(nullptr, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                         writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED) {
+            return nullptr;
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, bytes, MADV_HUGEPAGE);
+#endif
+        return new Mapping(ptr, bytes);
+    }
+};
+
+bool ECE_ChargeFile::makeHeader(std::uint64_t count, ChargeFileHeader& header, std::size_t& fileSize) {
+    // The largest 64-byte aligned array for which the header and four arrays still fit in a size_t
+    const std::size_t maxArrayBytes = (SIZE_MAX - sizeof(ChargeFileHeader)) / 4 / 64 * 64;
+    if (count > maxArrayBytes / sizeof(double)) {
+        return false;
+    }
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CHARGE_FILE_MAGIC, sizeof(header.magic));
+    header.count = count;
+    const std::size_t arrayBytes = (std::size_t(count) * sizeof(double) + 63) / 64 * 64;
+    for (int axis = 0; axis < 4; ++axis) {
+        header.offsets[axis] = sizeof(ChargeFileHeader) + axis * arrayBytes;
+    }
+    fileSize = sizeof(ChargeFileHeader) + 4 * arrayBytes;
+    return true;
+}
+
+/**
+ * Reads and checks the header of an open charge-set file: the magic, the
+ * array offsets, and that the file is at least as long as the header says.
+ *
+ * @param fd        The open file.
+ * @param filename  The file name, for the error messages.
+ * @param header    Reference to store the header.
+ * @param fileSize  Reference to store the size the header implies, in bytes.
+ * @return          True if the file is a complete charge-set file, false after printing an error.
+ */
+static bool readHeader(int fd, const std::string& filename, ChargeFileHeader& header, std::size_t& fileSize) {
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        std::cerr << "Error: Unable to read " << filename << std::endl;
+        return false;
+    }
+    if (std::uint64_t(info.st_size) < sizeof(header) || pread(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header))
+        || std::memcmp(header.magic, CHARGE_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << "Error: " << filename << " is not a charge-set file." << std::endl;
+        return false;
+    }
+    ChargeFileHeader expected;
+    if (!ECE_ChargeFile::makeHeader(header.count, expected, fileSize)
+        || std::memcmp(expected.offsets, header.offsets, sizeof(header.offsets)) != 0) {
+        std::cerr << "Error: " << filename << " has a corrupt header." << std::endl;
+        return false;
+    }
+    if (std::uint64_t(info.st_size) < fileSize) {
+        std::cerr << "Error: " << filename << " is truncated: " << header.count << " charges need " << fileSize
+                  << " bytes, the file has " << info.st_size << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+ECE_ChargeFile::ECE_ChargeFile(const std::string& filename)
+    : count(0), arrays{nullptr, nullptr, nullptr, nullptr} {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Unable to open file for reading: " << filename << std::endl;
+        return;
+    }
+    ChargeFileHeader header;
+    std::size_t fileSize = 0;
+    if (readHeader(fd, filename, header, fileSize)) {
+        mapping.reset(Mapping::map(fd, fileSize, false));
+        if (!mapping) {
+            std::cerr << "Error: Unable to map " << filename << std::endl;
+        } else {
+            count = std::size_t(header.count);
+            for (int axis = 0; axis < 4; ++axis) {
+                arrays[axis] = reinterpret_cast<double*>(mapping->bytes() + header.offsets[axis]);
+            }
+        }
+    }
+    close(fd);
+}
+
+ECE_ChargeFile::ECE_ChargeFile(const std::string& filename, std::size_t count)
+    : count(0), arrays{nullptr, nullptr, nullptr, nullptr} {
+    ChargeFileHeader header;
+    std::size_t fileSize;
+    if (!makeHeader(count, header, fileSize)) {
+        std::cerr << "Error: " << count << " charges do not fit in a charge-set file." << std::endl;
+        return;
+    }
+    int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: Unable to open file for writing: " << filename << std::endl;
+        return;
+    }
+    if (ftruncate(fd, off_t(fileSize)) == 0) {
+        mapping.reset(Mapping::map(fd, fileSize, true));
+    }
+    if (!mapping) {
+        std::cerr << "Error: Unable to create " << filename << std::endl;
+    } else {
+        std::memcpy(mapping->bytes(), &header, sizeof(header));
+        this->count = count;
+        for (int axis = 0; axis < 4; ++axis) {
+            arrays[axis] = reinterpret_cast<double*>(mapping->bytes() + header.offsets[axis]);
+        }
+    }
+    close(fd);
+}
+
+void ECE_ChargeFile::willNeed(std::size_t first, std::size_t last) const {
+    const std::size_t pageSize = std::size_t(sysconf(_SC_PAGESIZE));
+    for (int axis = 0; axis < 4 && mapping && first < last && last <= count; ++axis) {
+        std::size_t begin = std::size_t(reinterpret_cast<const char*>(arrays[axis] + first) - mapping->bytes());
+        std::size_t end = std::size_t(reinterpret_cast<const char*>(arrays[axis] + last) - mapping->bytes());
+        begin = begin / pageSize * pageSize;
+        madvise(mapping->bytes() + begin, end - begin, MADV_WILLNEED);
+    }
+}
+
+bool ECE_ChargeFile::readCount(const std::string& filename, std::size_t& count) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Unable to open file for reading: " << filename << std::endl;
+        return false;
+    }
+    ChargeFileHeader header;
+    std::size_t fileSize;
+    bool valid = readHeader(fd, filename, header, fileSize);
+    close(fd);
+    if (valid) {
+        count = std::size_t(header.count);
+    }
+    return valid;
+}
+
+ECE_ChargeFile::~ECE_ChargeFile() = default;
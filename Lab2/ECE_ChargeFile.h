@@ -0,0 +1,116 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_ChargeFile class.
+This class memory-maps a binary charge-set file, so the solver reads the
+x, y, z and q arrays straight from the page cache without parsing or
+copying them. The file is a 64-byte header followed by the four arrays
+(structure of arrays), each starting on a 64-byte boundary:
+
+    offset  0   char[8]     magic "ECECHG01"
+    offset  8   uint64      number of charges n
+    offset 16   uint64[4]   byte offsets of the x, y, z and q arrays
+    offset 48   char[16]    reserved, zero
+    then        double[n]   x, y, z in meters and q in Coulomb
+
+All values are little-endian.
+
+*/
+
+#ifndef ECE_CHARGEFILE_H
+#define ECE_CHARGEFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @brief The header at the start of a charge-set file.
+ */
+struct ChargeFileHeader {
+    char magic[8];
+    std::uint64_t count;
+    std::uint64_t offsets[4];
+    char reserved[16];
+};
+
+class ECE_ChargeFile {
+protected:
+    struct Mapping;                     // the mapped region, defined with the platform calls in the .cpp
+    std::unique_ptr<Mapping> mapping;   // empty if the file is not open
+    std::size_t count;                  // number of charges in the file
+    double* arrays[4];                  // the x, y, z and q arrays inside the mapping
+
+public:
+    /**
+     * @brief Map an existing charge-set file read-only.
+     * A file whose header is corrupt or that is shorter than its header says is reported and left unmapped.
+     *
+     * @param filename The file to map.
+     */
+    explicit ECE_ChargeFile(const std::string& filename);
+    /**
+     * @brief Create a charge-set file for a number of charges and map it for writing.
+     * The arrays are filled through getWritableArray and reach the file when the object is destroyed.
+     *
+     * @param filename The file to create, replacing any existing one.
+     * @param count The number of charges.
+     */
+    ECE_ChargeFile(const std::string& filename, std::size_t count);
+    /**
+     * @brief Unmaps the file.
+     */
+    ~ECE_ChargeFile();
+
+    ECE_ChargeFile(const ECE_ChargeFile&) = delete;
+    ECE_ChargeFile& operator=(const ECE_ChargeFile&) = delete;
+
+    /**
+     * @brief Check if the file was mapped.
+     */
+    bool isOpen() const { return mapping != nullptr; }
+    /**
+     * @brief Get the number of charges in the file.
+     */
+    std::size_t size() const { return count; }
+    /**
+     * @brief Get one of the arrays: 0 for x, 1 for y, 2 for z and 3 for q in Coulomb.
+     */
+    const double* getArray(int axis) const { return arrays[axis]; }
+    /**
+     * @brief Get one of the arrays of a file created for writing.
+     */
+    double* getWritableArray(int axis) { return arrays[axis]; }
+    /**
+     * @brief Ask the kernel to read ahead the charges [first, last) of all four arrays.
+     *
+     * @param first Index of the first charge.
+     * @param last One past the index of the last charge.
+     */
+    void willNeed(std::size_t first, std::size_t last) const;
+    /**
+     * @brief Read the number of charges from the header of a file without mapping it.
+     * The header and the file size are checked as when the file is mapped.
+     *
+     * @param filename The charge-set file.
+     * @param count Reference to store the number of charges.
+     * @return True if the file is a complete charge-set file, false otherwise.
+     */
+    static bool readCount(const std::string& filename, std::size_t& count);
+    /**
+     * @brief Compute the header of a file holding a number of charges.
+     *
+     * @param count The number of charges.
+     * @param header Reference to store the header.
+     * @param fileSize Reference to store the total size of the file in bytes.
+     * @return True if the size fits in a std::size_t, false if the count is too large.
+     */
+    static bool makeHeader(std::uint64_t count, ChargeFileHeader& header, std::size_t& fileSize);
+};
+
+#endif // ECE_CHARGEFILE_H
@@ -0,0 +1,218 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_ChargeTree class.
+Cells are split at the midpoint of their bounding box into up to eight
+children, the charges are then copied in tree order so that every cell is a
+contiguous range, and the moments of every cell are computed in parallel.
+
+*/
+
+#include "ECE_ChargeTree.h"
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+ECE_ChargeTree::ECE_ChargeTree(const ECE_ChargeArray& source, double theta, std::size_t leafSize)
+    : theta(theta), leafSize(leafSize < 1 ? 1 : leafSize) {
+    const std::size_t n = source.size();
+    std::vector<std::size_t> order(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        order[i] = i;
+    }
+
+    if (n > 0) {
+        build(source, order, 0, n, 0);
+    }
+
+    // Store the charges in tree order
+    charges.resize(n);
+    #pragma omp parallel for
+    for (long i = 0; i < long(n); ++i) {
+        charges.copyCharge(i, source, order[i]);
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for (long id = 0; id < long(nodes.size()); ++id) {
+        computeMoments(nodes[id]);
+    }
+}
+
+int ECE_ChargeTree::build(const ECE_ChargeArray& source, std::vector<std::size_t>& order,
+                          std::size_t begin, std::size_t end, int depth) {
+    int id = int(nodes.size());
+    nodes.push_back(Node());
+    nodes[id].begin = begin;
+    nodes[id].end = end;
+    std::fill(nodes[id].children, nodes[id].children + 8, -1);
+    nodes[id].leaf = (end - begin <= leafSize) || (depth >= MAX_DEPTH);
+    if (nodes[id].leaf) {
+        return id;
+    }
+
+    // Split at the middle of the bounding box of the cell
+    double minX = source.getX(order[begin]), maxX = minX;
+    double minY = source.getY(order[begin]), maxY = minY;
+    double minZ = source.getZ(order[begin]), maxZ = minZ;
+    for (std::size_t i = begin + 1; i < end; ++i) {
+        minX = std::min(minX, source.getX(order[i]));
+        maxX = std::max(maxX, source.getX(order[i]));
+        minY = std::min(minY, source.getY(order[i]));
+        maxY = std::max(maxY, source.getY(order[i]));
+        minZ = std::min(minZ, source.getZ(order[i]));
+        maxZ = std::max(maxZ, source.getZ(order[i]));
+    }
+    const double midX = 0.5 * (minX + maxX);
+    const double midY = 0.5 * (minY + maxY);
+    const double midZ = 0.5 * (minZ + maxZ);
+
+    // Partition the range into octants: bit 0 = x, bit 1 = y, bit 2 = z
+    std::vector<std::size_t>::iterator bounds[9];
+    bounds[0] = order.begin() + begin;
+    bounds[8] = order.begin() + end;
+    bounds[4] = std::partition(bounds[0], bounds[8], [&](std::size_t i) { return source.getZ(i) < midZ; });
+    for (int h = 0; h < 8; h += 4) {
+        bounds[h + 2] = std::partition(bounds[h], bounds[h + 4], [&](std::size_t i) { return source.getY(i) < midY; });
+        for (int g = h; g < h + 4; g += 2) {
+            bounds[g + 1] = std::partition(bounds[g], bounds[g + 2], [&](std::size_t i) { return source.getX(i) < midX; });
+        }
+    }
+
+    for (int c = 0; c < 8; ++c) {
+        std::size_t childBegin = bounds[c] - order.begin();
+        std::size_t childEnd = bounds[c + 1] - order.begin();
+        if (childEnd > childBegin) {
+            int child = build(source, order, childBegin, childEnd, depth + 1);
+            nodes[id].children[c] = child;
+        }
+    }
+    return id;
+}
+
+void ECE_ChargeTree::computeMoments(Node& node) const {
+    // Expansion center: centroid weighted by |q|, so it stays inside the cell for mixed signs
+    double weight = 0.0, cx = 0.0, cy = 0.0, cz = 0.0;
+    for (std::size_t i = node.begin; i < node.end; ++i) {
+        double w = std::abs(charges.getQ(i));
+        weight += w;
+        cx += w * charges.getX(i);
+        cy += w * charges.getY(i);
+        cz += w * charges.getZ(i);
+    }
+    if (weight > 0.0) {
+        cx /= weight;
+        cy /= weight;
+        cz /= weight;
+    } else {
+        cx = cy = cz = 0.0;
+        for (std::size_t i = node.begin; i < node.end; ++i) {
+            cx += charges.getX(i);
+            cy += charges.getY(i);
+            cz += charges.getZ(i);
+        }
+        double count = double(node.end - node.begin);
+        cx /= count;
+        cy /= count;
+        cz /= count;
+    }
+
+    node.cx = cx;
+    node.cy = cy;
+    node.cz = cz;
+    node.radius = 0.0;
+    node.q = 0.0;
+    node.px = node.py = node.pz = 0.0;
+    node.Qxx = node.Qyy = node.Qzz = 0.0;
+    node.Qxy = node.Qxz = node.Qyz = 0.0;
+
+    for (std::size_t i = node.begin; i < node.end; ++i) {
+        double q = charges.getQ(i);
+        double sx = charges.getX(i) - cx;
+        double sy = charges.getY(i) - cy;
+        double sz = charges.getZ(i) - cz;
+        double s_squared = sx * sx + sy * sy + sz * sz;
+
+        node.radius = std::max(node.radius, s_squared);
+        node.q += q;
+        node.px += q * sx;
+        node.py += q * sy;
+        node.pz += q * sz;
+        node.Qxx += q * (3.0 * sx * sx - s_squared);
+        node.Qyy += q * (3.0 * sy * sy - s_squared);
+        node.Qzz += q * (3.0 * sz * sz - s_squared);
+        node.Qxy += q * 3.0 * sx * sy;
+        node.Qxz += q * 3.0 * sx * sz;
+        node.Qyz += q * 3.0 * sy * sz;
+    }
+    node.radius = std::sqrt(node.radius);
+}
+
+void ECE_ChargeTree::computeFieldAt(double px, double py, double pz, double &Ex, double &Ey, double &Ez) const {
+    double directEx = 0.0, directEy = 0.0, directEz = 0.0;
+    double farEx = 0.0, farEy = 0.0, farEz = 0.0;
+    const double theta_squared = theta * theta;
+
+    if (nodes.empty()) {
+        Ex = Ey = Ez = 0.0;
+        return;
+    }
+
+    int stack[8 * MAX_DEPTH + 8];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        double dx = px - node.cx;
+        double dy = py - node.cy;
+        double dz = pz - node.cz;
+        double r_squared = dx * dx + dy * dy + dz * dz;
+
+        if (node.radius * node.radius < theta_squared * r_squared) {
+            // Far cell: monopole + dipole + quadrupole about the expansion center
+            double inv_r = 1.0 / std::sqrt(r_squared);
+            double inv_r2 = inv_r * inv_r;
+            double inv_r3 = inv_r2 * inv_r;
+            double inv_r5 = inv_r3 * inv_r2;
+            double inv_r7 = inv_r5 * inv_r2;
+
+            double pDotD = node.px * dx + node.py * dy + node.pz * dz;
+            double Qdx = node.Qxx * dx + node.Qxy * dy + node.Qxz * dz;
+            double Qdy = node.Qxy * dx + node.Qyy * dy + node.Qyz * dz;
+            double Qdz = node.Qxz * dx + node.Qyz * dy + node.Qzz * dz;
+            double dQd = dx * Qdx + dy * Qdy + dz * Qdz;
+
+            double radial = node.q * inv_r3 + 3.0 * pDotD * inv_r5 + 2.5 * dQd * inv_r7;
+            farEx += radial * dx - node.px * inv_r3 - Qdx * inv_r5;
+            farEy += radial * dy - node.py * inv_r3 - Qdy * inv_r5;
+            farEz += radial * dz - node.pz * inv_r3 - Qdz * inv_r5;
+        } else if (node.leaf) {
+            double tempEx, tempEy, tempEz;
+            charges.computeFieldAt(px, py, pz, node.begin, node.end, tempEx, tempEy, tempEz);
+            directEx += tempEx;
+            directEy += tempEy;
+            directEz += tempEz;
+        } else {
+            for (int c = 0; c < 8; ++c) {
+                if (node.children[c] >= 0) {
+                    stack[top++] = node.children[c];
+                }
+            }
+        }
+    }
+
+    Ex = directEx + ECE_ChargeArray::k * farEx;
+    Ey = directEy + ECE_ChargeArray::k * farEy;
+    Ez = directEz + ECE_ChargeArray::k * farEz;
+}
+
+void ECE_ChargeTree::evaluateField(const Point* pts, std::size_t m, Field* out) const {
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (long i = 0; i < long(m); ++i) {
+        computeFieldAt(pts[i].x, pts[i].y, pts[i].z, out[i].Ex, out[i].Ey, out[i].Ez);
+    }
+}
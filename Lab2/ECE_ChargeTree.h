@@ -0,0 +1,94 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_ChargeTree class.
+This class builds a Barnes-Hut octree over an ECE_ChargeArray once and then
+answers field queries in O(log N): distant cells are replaced by their
+monopole, dipole and quadrupole moments, near cells are summed directly
+with the SIMD kernel of ECE_ChargeArray.
+
+*/
+
+#ifndef ECE_CHARGETREE_H
+#define ECE_CHARGETREE_H
+
+#include "ECE_ChargeArray.h"
+#include <cstddef>
+#include <vector>
+
+class ECE_ChargeTree {
+protected:
+    /**
+     * @brief One cell of the octree. Its charges are the contiguous range
+     * [begin, end) of the reordered charge array.
+     */
+    struct Node {
+        double cx, cy, cz;      // expansion center (|q|-weighted centroid)
+        double radius;          // distance from the center to the farthest charge
+        double q;               // total charge (monopole)
+        double px, py, pz;      // dipole moment about the center
+        double Qxx, Qyy, Qzz;   // traceless quadrupole moment about the center
+        double Qxy, Qxz, Qyz;
+        std::size_t begin;      // first charge of the cell
+        std::size_t end;        // one past the last charge of the cell
+        int children[8];        // child node indices, -1 when absent
+        bool leaf;              // true when the charges are summed directly
+    };
+
+    ECE_ChargeArray charges;    // the charges reordered so every cell is contiguous
+    std::vector<Node> nodes;    // nodes[0] is the root
+    double theta;               // opening angle of the acceptance criterion
+    std::size_t leafSize;       // maximum number of charges in a leaf
+
+    static const int MAX_DEPTH = 48; // stops the recursion on coincident charges
+
+    int build(const ECE_ChargeArray& source, std::vector<std::size_t>& order,
+              std::size_t begin, std::size_t end, int depth);
+    void computeMoments(Node& node) const;
+
+public:
+    /**
+     * @brief Build the octree over a set of charges.
+     *
+     * @param source The charges to build the tree over.
+     * @param theta The opening angle: a cell of radius r at distance d is
+     *        approximated when r/d < theta. Smaller values are more accurate;
+     *        the relative error falls roughly as theta^3.
+     * @param leafSize The maximum number of charges summed directly in a leaf.
+     */
+    ECE_ChargeTree(const ECE_ChargeArray& source, double theta = 0.5, std::size_t leafSize = 64);
+    /**
+     * @brief Approximate the electric field of all charges at a specified point.
+     *
+     * @param px The x-coordinate where the electric field is calculated.
+     * @param py The y-coordinate where the electric field is calculated.
+     * @param pz The z-coordinate where the electric field is calculated.
+     * @param Ex Reference to store the electric field in the x-direction.
+     * @param Ey Reference to store the electric field in the y-direction.
+     * @param Ez Reference to store the electric field in the z-direction.
+     */
+    void computeFieldAt(double px, double py, double pz, double &Ex, double &Ey, double &Ez) const;
+    /**
+     * @brief Approximate the electric field at a batch of points, in parallel over the points.
+     *
+     * @param pts The query points.
+     * @param m The number of query points.
+     * @param out Array of m entries receiving the field at each point.
+     */
+    void evaluateField(const Point* pts, std::size_t m, Field* out) const;
+
+    /**
+     * @brief Get the number of nodes in the tree.
+     */
+    std::size_t getNodeCount() const { return nodes.size(); }
+    /**
+     * @brief Get the opening angle used by the acceptance criterion.
+     */
+    double getTheta() const { return theta; }
+};
+
+#endif // ECE_CHARGETREE_H
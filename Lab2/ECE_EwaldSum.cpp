@@ -0,0 +1,129 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_EwaldSum class.
+A query point is first moved into the unit cell around one charge, which
+changes neither sum, so the image list and the phases are computed once
+for every point of the plane.
+
+*/
+
+#include "ECE_EwaldSum.h"
+#include <cmath>
+
+/**
+ * Computes e^a erfc(x) without overflow. Both reciprocal terms have
+ * a - x^2 = -(|G| / 2 alpha)^2 - (alpha z)^2, so once erfc(x) underflows
+ * (x > 26) the product is below e^-338 and a cannot exceed x^2 / 2 before.
+ *
+ * @param a     The exponent.
+ * @param x     The argument of erfc.
+ * @return      e^a erfc(x).
+ */
+static inline double expErfc(double a, double x) {
+    return x > 26.0 ? 0.0 : std::exp(a) * std::erfc(x);
+}
+
+ECE_EwaldSum::ECE_EwaldSum(double xSeparation, double ySeparation, double x0, double y0, double q,
+                           double realCutoff, double reciprocalCutoff, double alpha)
+    : xSeparation(xSeparation), ySeparation(ySeparation), x0(x0), y0(y0), q(q * 1.0e-6),
+      alpha(alpha > 0.0 ? alpha : std::sqrt(reciprocalCutoff / (2.0 * realCutoff))), realCutoff(realCutoff),
+      reciprocalCutoff(reciprocalCutoff) {
+    // A reduced point lies within half a diagonal of the charge at the origin
+    const double reach = realCutoff + 0.5 * std::hypot(xSeparation, ySeparation);
+    const int ni = int(std::ceil(reach / xSeparation));
+    const int nj = int(std::ceil(reach / ySeparation));
+    for (int j = -nj; j <= nj; ++j) {
+        for (int i = -ni; i <= ni; ++i) {
+            if (std::hypot(i * xSeparation, j * ySeparation) <= reach) {
+                images.push_back(Point{i * xSeparation, j * ySeparation, 0.0});
+            }
+        }
+    }
+
+    // Half plane m > 0, or m = 0 and n > 0; the other half gives the same terms
+    const double gxUnit = 2.0 * M_PI / xSeparation;
+    const double gyUnit = 2.0 * M_PI / ySeparation;
+    const int mMax = int(reciprocalCutoff / gxUnit);
+    const int nMax = int(reciprocalCutoff / gyUnit);
+    for (int m = 0; m <= mMax; ++m) {
+        for (int n = (m == 0 ? 1 : -nMax); n <= nMax; ++n) {
+            const double gx = m * gxUnit, gy = n * gyUnit;
+            const double g = std::hypot(gx, gy);
+            if (g <= reciprocalCutoff) {
+                waves.push_back(Wave{gx, gy, g});
+            }
+        }
+    }
+}
+
+void ECE_EwaldSum::chooseCutoffs(double xSeparation, double ySeparation, double tolerance,
+                                 double& realCutoff, double& reciprocalCutoff) {
+    // erfc(alpha rc) and exp(-gc^2 / 4 alpha^2) both fall like exp(-p^2)
+    const double a = std::sqrt(M_PI / (xSeparation * ySeparation));
+    const double p = std::sqrt(-std::log(tolerance));
+    realCutoff = p / a;
+    reciprocalCutoff = 2.0 * a * p;
+}
+
+void ECE_EwaldSum::computeFieldAt(double x, double y, double z, double &Ex, double &Ey, double &Ez) const {
+    // Move the point into the unit cell centred on the charge at (x0, y0)
+    const double rx = x - x0 - std::floor((x - x0) / xSeparation + 0.5) * xSeparation;
+    const double ry = y - y0 - std::floor((y - y0) / ySeparation + 0.5) * ySeparation;
+    const double twoOverSqrtPi = 2.0 / std::sqrt(M_PI);
+    const double area = xSeparation * ySeparation;
+    double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+
+    // Real space: screened Coulomb terms of the nearby images
+    const double cutoff2 = realCutoff * realCutoff;
+    for (const Point& image : images) {
+        const double dx = rx - image.x;
+        const double dy = ry - image.y;
+        const double r_squared = dx * dx + dy * dy + z * z;
+        if (r_squared > cutoff2) {
+            continue;
+        }
+        const double r = std::sqrt(r_squared);
+        const double scale = (std::erfc(alpha * r) + twoOverSqrtPi * alpha * r * std::exp(-alpha * alpha * r_squared))
+                             / (r * r_squared);
+        sumX += scale * dx;
+        sumY += scale * dy;
+        sumZ += scale * z;
+    }
+
+    // Reciprocal space: G and -G together, so the sums get a factor 2
+    double waveX = 0.0, waveY = 0.0, waveZ = 0.0;
+    for (const Wave& wave : waves) {
+        const double phase = wave.gx * rx + wave.gy * ry;
+        const double u = wave.g / (2.0 * alpha);
+        const double above = expErfc(wave.g * z, u + alpha * z);
+        const double below = expErfc(-wave.g * z, u - alpha * z);
+        const double s = std::sin(phase) * (above + below) / wave.g;
+        waveX += wave.gx * s;
+        waveY += wave.gy * s;
+        waveZ -= std::cos(phase) * (above - below);
+    }
+    const double waveScale = 2.0 * M_PI / area;
+    sumX += waveScale * waveX;
+    sumY += waveScale * waveY;
+    sumZ += waveScale * waveZ;
+
+    // G = 0: the uniformly charged sheet
+    sumZ += 2.0 * M_PI / area * std::erf(alpha * z);
+
+    const double kq = ECE_ChargeArray::k * q;
+    Ex = kq * sumX;
+    Ey = kq * sumY;
+    Ez = kq * sumZ;
+}
+
+void ECE_EwaldSum::evaluateField(const Point* pts, std::size_t m, Field* out) const {
+    #pragma omp parallel for schedule(static)
+    for (long p = 0; p < long(m); ++p) {
+        computeFieldAt(pts[p].x, pts[p].y, pts[p].z, out[p].Ex, out[p].Ey, out[p].Ez);
+    }
+}
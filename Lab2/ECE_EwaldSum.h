@@ -0,0 +1,112 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_EwaldSum class.
+This class evaluates the electric field of an infinite, doubly periodic
+sheet of equal point charges, one per xSeparation x ySeparation cell of the
+plane z = 0, with the two-dimensional Ewald sum. It replaces the slowly
+converging sum over a huge finite lattice by two rapidly converging ones
+split by a parameter alpha:
+
+    real space (images R with |p - R| < rc)
+        E += k q d / r^3 (erfc(alpha r) + 2 alpha r / sqrt(pi) exp(-alpha^2 r^2)),  d = p - R
+    reciprocal space (G = 2 pi (m / a, n / b), 0 < |G| < gc, A = a b)
+        Exy += (pi k q / A) (G / |G|) sin(G.rho) (e^(|G| z) erfc(|G| / 2 alpha + alpha z)
+                                                 + e^(-|G| z) erfc(|G| / 2 alpha - alpha z))
+        Ez  -= (pi k q / A) cos(G.rho) (e^(|G| z) erfc(|G| / 2 alpha + alpha z)
+                                        - e^(-|G| z) erfc(|G| / 2 alpha - alpha z))
+    G = 0 (the charged sheet itself)
+        Ez += (2 pi k q / A) erf(alpha z)
+
+The truncation errors fall as erfc(alpha rc) and exp(-gc^2 / 4 alpha^2);
+alpha is chosen as sqrt(gc / 2 rc), which balances the two. The result does
+not depend on alpha once both sums have converged.
+
+*/
+
+#ifndef ECE_EWALDSUM_H
+#define ECE_EWALDSUM_H
+
+#include "ECE_ChargeArray.h"
+#include <cstddef>
+#include <vector>
+
+class ECE_EwaldSum {
+protected:
+    /**
+     * @brief A reciprocal-lattice vector; G and -G are summed together.
+     */
+    struct Wave {
+        double gx, gy;          // the vector G
+        double g;               // |G|
+    };
+
+    double xSeparation, ySeparation; // sides a and b of the unit cell
+    double x0, y0;                  // position of one charge of the sheet
+    double q;                       // charge of every point in Coulomb
+    double alpha;                   // splitting parameter in 1/m
+    double realCutoff;              // rc in m
+    double reciprocalCutoff;        // gc in 1/m
+    std::vector<Point> images;      // in-plane lattice vectors that can lie within rc of a reduced point
+    std::vector<Wave> waves;        // half of the reciprocal vectors with 0 < |G| < gc
+
+public:
+    /**
+     * @brief Constructor for ECE_EwaldSum class.
+     *
+     * @param xSeparation The distance between charges along x.
+     * @param ySeparation The distance between charges along y.
+     * @param x0 The x-coordinate of one charge of the sheet.
+     * @param y0 The y-coordinate of one charge of the sheet.
+     * @param q The charge of every point in micro Coulomb.
+     * @param realCutoff The real-space cutoff rc in meters.
+     * @param reciprocalCutoff The reciprocal-space cutoff gc in 1/m.
+     * @param alpha The splitting parameter, 0 to balance the two truncation errors.
+     */
+    ECE_EwaldSum(double xSeparation, double ySeparation, double x0, double y0, double q,
+                 double realCutoff, double reciprocalCutoff, double alpha = 0.0);
+    /**
+     * @brief Choose the cutoffs for a relative truncation error with alpha = sqrt(pi / A).
+     *
+     * @param xSeparation The distance between charges along x.
+     * @param ySeparation The distance between charges along y.
+     * @param tolerance The wanted truncation error, e.g. 1e-12.
+     * @param realCutoff Reference to store rc in meters.
+     * @param reciprocalCutoff Reference to store gc in 1/m.
+     */
+    static void chooseCutoffs(double xSeparation, double ySeparation, double tolerance,
+                              double& realCutoff, double& reciprocalCutoff);
+    /**
+     * @brief Calculate the electric field of the periodic sheet at a point.
+     *
+     * @param x The x-coordinate where the electric field is calculated.
+     * @param y The y-coordinate where the electric field is calculated.
+     * @param z The z-coordinate where the electric field is calculated.
+     * @param Ex Reference to store the electric field in the x-direction.
+     * @param Ey Reference to store the electric field in the y-direction.
+     * @param Ez Reference to store the electric field in the z-direction.
+     */
+    void computeFieldAt(double x, double y, double z, double &Ex, double &Ey, double &Ez) const;
+    /**
+     * @brief Evaluate the field at a batch of points, shared out over the OpenMP threads.
+     *
+     * @param pts The query points.
+     * @param m The number of query points.
+     * @param out Array of m entries receiving the field at each point.
+     */
+    void evaluateField(const Point* pts, std::size_t m, Field* out) const;
+
+    double getAlpha() const { return alpha; }
+    double getRealCutoff() const { return realCutoff; }
+    double getReciprocalCutoff() const { return reciprocalCutoff; }
+    /**
+     * @brief Get the number of terms of one query, real-space images plus reciprocal vectors (G and -G once).
+     */
+    std::size_t getTermCount() const { return images.size() + waves.size(); }
+};
+
+#endif // ECE_EWALDSUM_H
@@ -0,0 +1,233 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_FieldLineTracer class.
+The active lines are kept in a compact list; after every step the lines
+that ended are dropped from it, so the batched queries only carry the
+points of lines that are still moving.
+
+*/
+
+#include "ECE_FieldLineTracer.h"
+#include "ECE_ResultSink.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Dormand-Prince 5(4) tableau; the last row is also the fifth-order solution
+static const double DP_A[7][6] = {
+    {0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+    {1.0 / 5.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+    {3.0 / 40.0, 9.0 / 40.0, 0.0, 0.0, 0.0, 0.0},
+    {44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0, 0.0, 0.0, 0.0},
+    {19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0, 0.0, 0.0},
+    {9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0, 0.0},
+    {35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0}};
+// Fifth- minus fourth-order weights, the local error estimate
+static const double DP_E[7] = {71.0 / 57600.0, 0.0, -71.0 / 16695.0, 71.0 / 1920.0,
+                               -17253.0 / 339200.0, 22.0 / 525.0, -1.0 / 40.0};
+
+/**
+ * Writes a 32-bit value in big-endian byte order, as legacy VTK binary files require.
+ *
+ * @param out       The output stream.
+ * @param bits      The bits of the value.
+ */
+static void writeBigEndian32(std::ofstream& out, uint32_t bits) {
+    unsigned char bytes[4];
+    toBigEndian32(bits, bytes);
+    out.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+}
+
+ECE_FieldLineTracer::ECE_FieldLineTracer(const FieldEvaluator& evaluate, const TraceSettings& settings)
+    : evaluate(evaluate), settings(settings), offsets(1, 0), acceptedSteps(0), rejectedSteps(0),
+      evaluatedPoints(0), batches(0) {}
+
+void ECE_FieldLineTracer::direction(const Field* fields, std::size_t m, Point* k, std::vector<char>* zero) const {
+    #pragma omp parallel for schedule(static)
+    for (long a = 0; a < long(m); ++a) {
+        const Field& E = fields[a];
+        double norm = std::sqrt(E.Ex * E.Ex + E.Ey * E.Ey + E.Ez * E.Ez);
+        double scale = norm > 0.0 && std::isfinite(norm) ? settings.direction / norm : 0.0;
+        k[a] = Point{E.Ex * scale, E.Ey * scale, E.Ez * scale};
+        if (zero != nullptr) {
+            (*zero)[a] = scale == 0.0;
+        }
+    }
+}
+
+void ECE_FieldLineTracer::trace(const Point* seeds, std::size_t n) {
+    std::vector<std::vector<float>> lines(n);
+    reasons.assign(n, ACTIVE);
+    acceptedSteps = rejectedSteps = evaluatedPoints = batches = 0;
+
+    // State of every line, indexed by line
+    std::vector<Point> position(seeds, seeds + n);
+    std::vector<Point> k1(n);
+    std::vector<double> step(n, std::min(settings.initialStep, settings.maxStep));
+    std::vector<double> length(n, 0.0);
+    std::vector<int> steps(n, 0);
+
+    // The first stage of the first step is the field at the seeds
+    std::vector<Field> fields(n);
+    std::vector<char> zero(n);
+    evaluate(seeds, n, fields.data());
+    evaluatedPoints += n;
+    ++batches;
+    direction(fields.data(), n, k1.data(), &zero);
+
+    std::vector<std::size_t> active;
+    for (std::size_t i = 0; i < n; ++i) {
+        lines[i].insert(lines[i].end(), {float(seeds[i].x), float(seeds[i].y), float(seeds[i].z)});
+        if (zero[i]) {
+            reasons[i] = ZERO_FIELD;
+        } else {
+            active.push_back(i);
+        }
+    }
+
+    // Stage slopes and points of the active lines, indexed by their slot in the active list
+    std::vector<Point> k[7];
+    std::vector<Point> stage;
+    while (!active.empty()) {
+        const std::size_t m = active.size();
+        for (std::vector<Point>& slopes : k) {
+            slopes.resize(m);
+        }
+        stage.resize(m);
+        fields.resize(m);
+        zero.resize(m);
+        #pragma omp parallel for schedule(static)
+        for (long a = 0; a < long(m); ++a) {
+            k[0][a] = k1[active[a]];
+        }
+
+        // Stages 2 to 7, one batched query each; stage 7 is at the fifth-order solution
+        for (int s = 1; s < 7; ++s) {
+            #pragma omp parallel for schedule(static)
+            for (long a = 0; a < long(m); ++a) {
+                const std::size_t i = active[a];
+                Point p = position[i];
+                for (int j = 0; j < s; ++j) {
+                    const double w = step[i] * DP_A[s][j];
+                    p.x += w * k[j][a].x;
+                    p.y += w * k[j][a].y;
+                    p.z += w * k[j][a].z;
+                }
+                stage[a] = p;
+            }
+            evaluate(stage.data(), m, fields.data());
+            evaluatedPoints += m;
+            ++batches;
+            direction(fields.data(), m, k[s].data(), s == 6 ? &zero : nullptr);
+        }
+
+        // Accept or reject every step and adapt its size
+        unsigned long long accepted = 0;
+        #pragma omp parallel for schedule(static) reduction(+:accepted)
+        for (long a = 0; a < long(m); ++a) {
+            const std::size_t i = active[a];
+            double ex = 0.0, ey = 0.0, ez = 0.0;
+            for (int j = 0; j < 7; ++j) {
+                ex += DP_E[j] * k[j][a].x;
+                ey += DP_E[j] * k[j][a].y;
+                ez += DP_E[j] * k[j][a].z;
+            }
+            const double error = step[i] * std::sqrt(ex * ex + ey * ey + ez * ez);
+            const bool ok = std::isfinite(error) && error <= settings.tolerance;
+            if (ok) {
+                position[i] = stage[a];
+                length[i] += step[i];
+                ++steps[i];
+                ++accepted;
+                k1[i] = k[6][a];
+                lines[i].insert(lines[i].end(), {float(stage[a].x), float(stage[a].y), float(stage[a].z)});
+            }
+
+            double factor = std::isfinite(error) && error > 0.0
+                                ? 0.9 * std::pow(settings.tolerance / error, 0.2) : (std::isfinite(error) ? 5.0 : 0.2);
+            factor = std::min(5.0, std::max(0.2, factor));
+            // A remainder shorter than the minimum step is the end of the line, not a collapsed step
+            const double remaining = settings.maxLength - length[i];
+            step[i] = std::min(step[i] * factor, settings.maxStep);
+            step[i] = std::min(step[i], remaining);
+
+            if (remaining < settings.minStep || length[i] >= settings.maxLength * (1.0 - 1e-12)) {
+                reasons[i] = MAX_LENGTH;
+            } else if (steps[i] >= settings.maxSteps) {
+                reasons[i] = MAX_STEPS;
+            } else if (ok && zero[a]) {
+                reasons[i] = ZERO_FIELD;
+            } else if (step[i] < settings.minStep) {
+                reasons[i] = MIN_STEP;
+            }
+        }
+        acceptedSteps += accepted;
+        rejectedSteps += m - accepted;
+
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [&](std::size_t i) { return reasons[i] != ACTIVE; }),
+                     active.end());
+    }
+
+    // Flatten the polylines
+    offsets.assign(1, 0);
+    vertices.clear();
+    for (std::vector<float>& line : lines) {
+        vertices.insert(vertices.end(), line.begin(), line.end());
+        offsets.push_back(vertices.size() / 3);
+        std::vector<float>().swap(line);
+    }
+}
+
+bool ECE_FieldLineTracer::save(const std::string& filename) const {
+    std::ofstream outFile(filename, std::ios::binary);
+    if (!outFile.is_open()) {
+        std::cerr << "Error: Unable to open file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    const std::size_t numLines = getLineCount();
+    const std::size_t numVertices = getVertexCount();
+    const bool vtk = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".vtk") == 0;
+
+    if (vtk) {
+        outFile << "# vtk DataFile Version 3.0\n"
+                << "Electric field lines\n"
+                << "BINARY\n"
+                << "DATASET POLYDATA\n"
+                << "POINTS " << numVertices << " float\n";
+        for (float value : vertices) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            writeBigEndian32(outFile, bits);
+        }
+        outFile << "\nLINES " << numLines << " " << numLines + numVertices << "\n";
+        for (std::size_t i = 0; i < numLines; ++i) {
+            writeBigEndian32(outFile, uint32_t(offsets[i + 1] - offsets[i]));
+            for (std::size_t v = offsets[i]; v < offsets[i + 1]; ++v) {
+                writeBigEndian32(outFile, uint32_t(v));
+            }
+        }
+        outFile << "\n";
+    } else {
+        const uint64_t counts[2] = {numLines, numVertices};
+        outFile.write("EFLINES1", 8);
+        outFile.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+        for (std::size_t offset : offsets) {
+            const uint64_t value = offset;
+            outFile.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        outFile.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(float));
+    }
+
+    outFile.close();
+    return bool(outFile);
+}
@@ -0,0 +1,120 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_FieldLineTracer class.
+This class traces electric field lines from many seed points at once with
+the adaptive Dormand-Prince RK45 method, integrating
+    dr/ds = E(r) / |E(r)|
+over the arc length s. All active lines advance together: every stage of a
+step is one batched field query over the current stage points of all
+lines, and the stage arithmetic is shared out over the OpenMP threads. The
+step of every line adapts so that the local error estimate stays below a
+tolerance in meters, and the fifth-order stage of an accepted step is
+reused as the first stage of the next one, so a step costs six queries.
+
+A line ends when it reaches the maximum length (or is closer to it than
+the minimum step) or the step count, when the field vanishes, or when the
+step falls below the minimum, which happens where lines converge into a
+charge.
+
+The lines are kept as compact polylines of float vertices and saved either
+as a legacy VTK polydata file (".vtk") or in the raw binary format:
+
+    char[8]         magic "EFLINES1"
+    uint64          number of lines n
+    uint64          number of vertices v
+    uint64[n + 1]   index of the first vertex of every line, then v
+    float32[3 v]    x, y, z of the vertices
+
+*/
+
+#ifndef ECE_FIELDLINETRACER_H
+#define ECE_FIELDLINETRACER_H
+
+#include "ECE_ChargeArray.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A batched field query: fills the fields at m points.
+ */
+typedef std::function<void(const Point* pts, std::size_t m, Field* out)> FieldEvaluator;
+
+/**
+ * @brief The integration settings of the tracer; lengths are in meters.
+ */
+struct TraceSettings {
+    double maxLength = 1.0;     // arc length after which a line ends
+    double tolerance = 1e-6;    // largest local error of one step
+    double initialStep = 1e-3;  // first step of every line
+    double minStep = 1e-9;      // a line ends when its step falls below this
+    double maxStep = 0.1;       // largest step
+    int maxSteps = 100000;      // accepted steps after which a line ends
+    int direction = 1;          // 1 to follow the field, -1 to go against it
+};
+
+class ECE_FieldLineTracer {
+public:
+    /**
+     * @brief Why a line ended.
+     */
+    enum EndReason { ACTIVE, MAX_LENGTH, MAX_STEPS, ZERO_FIELD, MIN_STEP };
+
+protected:
+    FieldEvaluator evaluate;                // the batched field query
+    TraceSettings settings;
+    std::vector<std::size_t> offsets;       // first vertex of every line, then the vertex count
+    std::vector<float> vertices;            // x, y, z of all vertices, line after line
+    std::vector<EndReason> reasons;         // why every line ended
+    unsigned long long acceptedSteps;
+    unsigned long long rejectedSteps;
+    unsigned long long evaluatedPoints;     // points passed to the field query
+    unsigned long long batches;             // calls of the field query
+
+    void direction(const Field* fields, std::size_t m, Point* k, std::vector<char>* zero) const;
+
+public:
+    /**
+     * @brief Constructor for ECE_FieldLineTracer class.
+     *
+     * @param evaluate The batched field query, e.g. ECE_ChargeArray::evaluateField.
+     * @param settings The integration settings.
+     */
+    ECE_FieldLineTracer(const FieldEvaluator& evaluate, const TraceSettings& settings);
+    /**
+     * @brief Trace one field line from every seed point, replacing the previous lines.
+     *
+     * @param seeds The seed points.
+     * @param n The number of seeds.
+     */
+    void trace(const Point* seeds, std::size_t n);
+    /**
+     * @brief Save the lines to a file. A ".vtk" extension writes a legacy VTK
+     * polydata file, anything else the raw binary format.
+     *
+     * @param filename The name of the output file.
+     * @return True if the file was written, false otherwise.
+     */
+    bool save(const std::string& filename) const;
+
+    std::size_t getLineCount() const { return reasons.size(); }
+    std::size_t getVertexCount() const { return vertices.size() / 3; }
+    /**
+     * @brief Get the vertices [getLineStart(i), getLineStart(i + 1)) of line i.
+     */
+    std::size_t getLineStart(std::size_t i) const { return offsets[i]; }
+    const float* getVertex(std::size_t v) const { return &vertices[3 * v]; }
+    EndReason getEndReason(std::size_t i) const { return reasons[i]; }
+    unsigned long long getAcceptedSteps() const { return acceptedSteps; }
+    unsigned long long getRejectedSteps() const { return rejectedSteps; }
+    unsigned long long getEvaluatedPoints() const { return evaluatedPoints; }
+    unsigned long long getBatchCount() const { return batches; }
+};
+
+#endif // ECE_FIELDLINETRACER_H
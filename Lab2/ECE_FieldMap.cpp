@@ -0,0 +1,255 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_FieldMap class.
+The charge grid and the kernel are zero-padded to powers of two large enough
+that the circular convolution equals the linear one. Since the charge grid is
+real, Ex and Ey are convolved together as the real and imaginary parts of one
+complex kernel, so a whole map costs three forward and two inverse FFTs.
+
+*/
+
+#include "ECE_FieldMap.h"
+#include "ECE_ResultSink.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <omp.h>
+
+constexpr double ECE_FieldMap::k;
+
+/**
+ * Returns the smallest power of two that is not less than n.
+ *
+ * @param n     A positive integer.
+ * @return      The power of two.
+ */
+static int nextPowerOfTwo(int n) {
+    int p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+/**
+ * In-place iterative radix-2 FFT of a strided sequence (unnormalized).
+ *
+ * @param a         The first element of the sequence.
+ * @param n         The length of the sequence, a power of two.
+ * @param twiddle   The n/2 roots of unity exp(-2*pi*i*k/n).
+ * @param inverse   True for the inverse transform (conjugated roots).
+ */
+static void fft1D(std::complex<double>* a, int n, const std::vector<std::complex<double>>& twiddle, bool inverse) {
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(a[i], a[j]);
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len >> 1;
+        int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int j = 0; j < half; ++j) {
+                std::complex<double> w = inverse ? std::conj(twiddle[j * step]) : twiddle[j * step];
+                std::complex<double> u = a[i + j];
+                std::complex<double> v = a[i + j + half] * w;
+                a[i + j] = u + v;
+                a[i + j + half] = u - v;
+            }
+        }
+    }
+}
+
+/**
+ * Computes the roots of unity used by fft1D.
+ *
+ * @param n     The transform length.
+ * @return      The n/2 roots exp(-2*pi*i*k/n).
+ */
+static std::vector<std::complex<double>> makeTwiddles(int n) {
+    std::vector<std::complex<double>> twiddle(std::max(1, n / 2));
+    for (int i = 0; i < n / 2; ++i) {
+        twiddle[i] = std::polar(1.0, -2.0 * M_PI * i / n);
+    }
+    return twiddle;
+}
+
+void ECE_FieldMap::fft2D(ComplexGrid& data, int nRows, int nCols, bool inverse) {
+    const std::vector<std::complex<double>> rowTwiddle = makeTwiddles(nCols);
+    const std::vector<std::complex<double>> colTwiddle = makeTwiddles(nRows);
+
+    #pragma omp parallel
+    {
+        #pragma omp for
+        for (int i = 0; i < nRows; ++i) {
+            fft1D(&data[std::size_t(i) * nCols], nCols, rowTwiddle, inverse);
+        }
+
+        // Columns are gathered into a contiguous buffer so the transform runs on unit stride
+        std::vector<std::complex<double>> column(nRows);
+        #pragma omp for
+        for (int j = 0; j < nCols; ++j) {
+            for (int i = 0; i < nRows; ++i) {
+                column[i] = data[std::size_t(i) * nCols + j];
+            }
+            fft1D(column.data(), nRows, colTwiddle, inverse);
+            for (int i = 0; i < nRows; ++i) {
+                data[std::size_t(i) * nCols + j] = column[i];
+            }
+        }
+    }
+}
+
+ECE_FieldMap::ECE_FieldMap(int rows, int cols, double xSeparation, double ySeparation, double q, int margin)
+    : rows(rows), cols(cols), xSeparation(xSeparation), ySeparation(ySeparation),
+      q(q * 1.0e-6), margin(margin < 0 ? 0 : margin), z(0.0) {
+    mapRows = rows + 2 * this->margin;
+    mapCols = cols + 2 * this->margin;
+}
+
+void ECE_FieldMap::compute(double z) {
+    this->z = z;
+
+    // Padded sizes so that no output point wraps around onto another
+    const int nRows = nextPowerOfTwo(rows + mapRows - 1);
+    const int nCols = nextPowerOfTwo(cols + mapCols - 1);
+    const std::size_t total = std::size_t(nRows) * nCols;
+
+    ComplexGrid charge(total, std::complex<double>(0.0, 0.0));
+    #pragma omp parallel for
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            charge[std::size_t(i) * nCols + j] = q;
+        }
+    }
+    fft2D(charge, nRows, nCols, false);
+
+    // Kernel entry (u, v) holds the field of a unit charge at a lattice offset
+    // of (u, v) from the observation point, wrapped into the padded grid.
+    ComplexGrid kernelXY(total), kernelZ(total);
+    #pragma omp parallel for
+    for (int u = 0; u < nRows; ++u) {
+        int di = (u < mapRows ? u : u - nRows) - margin;
+        double dy = di * ySeparation;
+        for (int v = 0; v < nCols; ++v) {
+            int dj = (v < mapCols ? v : v - nCols) - margin;
+            double dx = dj * xSeparation;
+            double r_squared = dx * dx + dy * dy + z * z;
+            std::size_t idx = std::size_t(u) * nCols + v;
+            if (r_squared == 0.0) {
+                kernelXY[idx] = 0.0;
+                kernelZ[idx] = 0.0;
+                continue;
+            }
+            double scale = k / (sqrt(r_squared) * r_squared);
+            kernelXY[idx] = std::complex<double>(scale * dx, scale * dy);
+            kernelZ[idx] = scale * z;
+        }
+    }
+    fft2D(kernelXY, nRows, nCols, false);
+    fft2D(kernelZ, nRows, nCols, false);
+
+    #pragma omp parallel for
+    for (long idx = 0; idx < long(total); ++idx) {
+        kernelXY[idx] *= charge[idx];
+        kernelZ[idx] *= charge[idx];
+    }
+    charge.clear();
+    charge.shrink_to_fit();
+
+    fft2D(kernelXY, nRows, nCols, true);
+    fft2D(kernelZ, nRows, nCols, true);
+
+    const double norm = 1.0 / double(total);
+    Ex.resize(std::size_t(mapRows) * mapCols);
+    Ey.resize(std::size_t(mapRows) * mapCols);
+    Ez.resize(std::size_t(mapRows) * mapCols);
+    #pragma omp parallel for
+    for (int i = 0; i < mapRows; ++i) {
+        for (int j = 0; j < mapCols; ++j) {
+            std::size_t src = std::size_t(i) * nCols + j;
+            std::size_t dst = std::size_t(i) * mapCols + j;
+            Ex[dst] = kernelXY[src].real() * norm;
+            Ey[dst] = kernelXY[src].imag() * norm;
+            Ez[dst] = kernelZ[src].real() * norm;
+        }
+    }
+}
+
+void ECE_FieldMap::getElectricField(int i, int j, double &Ex, double &Ey, double &Ez) const {
+    std::size_t idx = std::size_t(i) * mapCols + j;
+    Ex = this->Ex[idx];
+    Ey = this->Ey[idx];
+    Ez = this->Ez[idx];
+}
+
+bool ECE_FieldMap::save(const std::string& filename) const {
+    const bool vtk = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".vtk") == 0;
+
+    if (vtk) {
+        // The map is a one-layer probe grid with x fastest, written by the VTK result sink
+        const ProbeGrid grid = {{getOriginX(), getOriginX() + (mapCols - 1) * xSeparation, getOriginY(),
+                                 getOriginY() + (mapRows - 1) * ySeparation, z, z}, {mapCols, mapRows, 1}};
+        std::unique_ptr<ECE_ResultSink> sink = ECE_ResultSink::create(filename, false, &grid);
+        if (!sink->isOpen()) {
+            return false;
+        }
+        std::vector<double> records(6 * std::size_t(mapCols));
+        bool ok = true;
+        for (int i = 0; i < mapRows && ok; ++i) {
+            for (int j = 0; j < mapCols; ++j) {
+                std::size_t idx = std::size_t(i) * mapCols + j;
+                double* r = &records[6 * j];
+                r[0] = getOriginX() + j * xSeparation;
+                r[1] = getOriginY() + i * ySeparation;
+                r[2] = z;
+                r[3] = Ex[idx];
+                r[4] = Ey[idx];
+                r[5] = Ez[idx];
+            }
+            ok = sink->writeChunk(records.data(), mapCols);
+        }
+        return ok && sink->finish();
+    }
+
+    std::ofstream outFile(filename, std::ios::binary);
+    if (!outFile.is_open()) {
+        std::cerr << "Error: Unable to open file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    const int32_t dims[2] = {mapRows, mapCols};
+    const double geometry[5] = {getOriginX(), getOriginY(), z, xSeparation, ySeparation};
+    outFile.write("EFMAP", 5);
+    outFile.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+    outFile.write(reinterpret_cast<const char*>(geometry), sizeof(geometry));
+
+    // Stream the interleaved triplets one row at a time
+    std::vector<double> row(3 * std::size_t(mapCols));
+    for (int i = 0; i < mapRows; ++i) {
+        for (int j = 0; j < mapCols; ++j) {
+            std::size_t idx = std::size_t(i) * mapCols + j;
+            row[3 * j] = Ex[idx];
+            row[3 * j + 1] = Ey[idx];
+            row[3 * j + 2] = Ez[idx];
+        }
+        outFile.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(double));
+    }
+
+    outFile.close();
+    return bool(outFile);
+}
@@ -0,0 +1,93 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_FieldMap class.
+This class computes Ex/Ey/Ez over a whole observation plane at height z
+above the regular rows x cols charge lattice. Because every charge sits on
+the lattice, the field on a grid with the same spacing is a 2D convolution
+of the charge grid with the Coulomb kernel, which is evaluated with
+zero-padded FFTs in O(N log N) instead of the O(N^2) direct sum.
+
+*/
+
+#ifndef ECE_FIELDMAP_H
+#define ECE_FIELDMAP_H
+
+#include <complex>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class ECE_FieldMap {
+protected:
+    int rows;               // number of lattice rows (y-direction)
+    int cols;               // number of lattice columns (x-direction)
+    double xSeparation;     // lattice spacing in the x-direction
+    double ySeparation;     // lattice spacing in the y-direction
+    double q;               // charge of every lattice point in Coulomb
+    int margin;             // extra observation points on each side of the lattice
+    double z;               // height of the observation plane
+
+    int mapRows;            // rows of the observation grid
+    int mapCols;            // columns of the observation grid
+    std::vector<double> Ex; // field on the observation grid, row-major
+    std::vector<double> Ey;
+    std::vector<double> Ez;
+
+    typedef std::vector<std::complex<double>> ComplexGrid;
+    static void fft2D(ComplexGrid& data, int nRows, int nCols, bool inverse);
+
+public:
+    static constexpr double k = 9.0e9; // Coulomb's constant N*m^2 /C^2
+
+    /**
+     * @brief Constructor for ECE_FieldMap class.
+     *
+     * @param rows The number of rows of the charge lattice.
+     * @param cols The number of columns of the charge lattice.
+     * @param xSeparation The x separation distance in meters.
+     * @param ySeparation The y separation distance in meters.
+     * @param q The common charge on the points in micro Coulomb.
+     * @param margin The number of extra observation points on each side of the lattice.
+     */
+    ECE_FieldMap(int rows, int cols, double xSeparation, double ySeparation, double q, int margin = 0);
+    /**
+     * @brief Compute the field over the observation plane at a height z.
+     * Observation points that coincide with a charge (z = 0) skip that charge.
+     *
+     * @param z The height of the observation plane in meters.
+     */
+    void compute(double z);
+    /**
+     * @brief Stream the computed map to a file. A ".vtk" extension writes a
+     * legacy VTK structured-points file, anything else the raw binary format:
+     * the header "EFMAP" followed by int32 rows and cols, float64 originX,
+     * originY, z, xSeparation and ySeparation, then Ex, Ey, Ez as float64
+     * triplets in row-major order.
+     *
+     * @param filename The name of the output file.
+     * @return True if the file was written, false otherwise.
+     */
+    bool save(const std::string& filename) const;
+
+    int getMapRows() const { return mapRows; }
+    int getMapCols() const { return mapCols; }
+    double getOriginX() const { return -(double(cols - 1) / 2.0 + margin) * xSeparation; }
+    double getOriginY() const { return -(double(rows - 1) / 2.0 + margin) * ySeparation; }
+    /**
+     * @brief Get the field at an observation point.
+     *
+     * @param i The row of the observation grid.
+     * @param j The column of the observation grid.
+     * @param Ex Reference to store the electric field in the x-direction.
+     * @param Ey Reference to store the electric field in the y-direction.
+     * @param Ez Reference to store the electric field in the z-direction.
+     */
+    void getElectricField(int i, int j, double &Ex, double &Ey, double &Ez) const;
+};
+
+#endif // ECE_FIELDMAP_H
@@ -0,0 +1,378 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header-only fused kernel for the electric potential V, the field E and the
+field-gradient tensor dEi/dxj of an ECE_ChargeArray. All three come out of
+one sweep over the charges and share 1/r, q/r^3 and the displacement. The
+wanted outputs are a template parameter, so terms that are not requested
+are removed at compile time and cost nothing:
+
+    evaluateTerms<OUTPUT_POTENTIAL | OUTPUT_FIELD>(charges, pts, m, out);
+
+The gradient of E = k q d / r^3 (d = p - c) is
+    dEi/dxj = k q (delta_ij / r^3 - 3 d_i d_j / r^5),
+which is symmetric and traceless away from the charges.
+
+An optional softening length eps replaces r^2 by r^2 + eps^2 (Plummer
+softening) in all terms, which keeps them finite at the charges; a point
+on a charge then gets no field from it, and a potential of k q / eps.
+
+*/
+
+#ifndef ECE_FIELDTERMS_H
+#define ECE_FIELDTERMS_H
+
+#include "ECE_ChargeArray.h"
+#include "ECE_PairwiseSum.h"
+#include "ECE_SimdMath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include <omp.h>
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Flags selecting the outputs of the fused kernel.
+ */
+enum FieldOutputs : unsigned {
+    OUTPUT_POTENTIAL = 1u,
+    OUTPUT_FIELD = 2u,
+    OUTPUT_GRADIENT = 4u,
+    OUTPUT_ALL = 7u
+};
+
+/**
+ * @brief Potential, field and field gradient at a point. Outputs that were
+ * not requested are left at zero.
+ */
+struct FieldTerms {
+    double V;                           // potential in V
+    double Ex, Ey, Ez;                  // field in V/m
+    double Gxx, Gyy, Gzz, Gxy, Gxz, Gyz; // symmetric gradient dEi/dxj in V/m^2
+};
+
+/**
+ * @brief Number of accumulators per point and points per block for a set of outputs,
+ * chosen so that all accumulators of a block stay in vector registers.
+ */
+template <unsigned Outputs>
+struct TermsBlock {
+    static const int accumulators = ((Outputs & OUTPUT_POTENTIAL) ? 1 : 0) + ((Outputs & OUTPUT_FIELD) ? 3 : 0)
+                                    + ((Outputs & OUTPUT_GRADIENT) ? 6 : 0);
+#if defined(__AVX512F__)
+    static const int points = accumulators <= 4 ? 4 : 2;   // 32 zmm registers
+#else
+    static const int points = accumulators <= 4 ? 2 : 1;   // 16 ymm registers
+#endif
+};
+
+/**
+ * Adds the terms of the charges [begin, end) at P points to out, without the Coulomb constant.
+ * 1/r, q/r^3 and 3q/r^5 are computed once per charge and point and shared by all outputs;
+ * each group of charges is loaded once and reused for all P points.
+ *
+ * @param xs, ys, zs, qs    The charge arrays, q in Coulomb.
+ * @param begin             Index of the first charge to include.
+ * @param end               One past the index of the last charge to include.
+ * @param pts               The P query points.
+ * @param out               The P sets of terms to accumulate into.
+ * @param softening2        The squared softening length, 0 for the exact Coulomb terms.
+ */
+template <unsigned Outputs, int P>
+inline void accumulateTerms(const double* xs, const double* ys, const double* zs, const double* qs,
+                            std::size_t begin, std::size_t end, const Point* pts, FieldTerms* out,
+                            double softening2) {
+    const bool wantV = (Outputs & OUTPUT_POTENTIAL) != 0;
+    const bool wantE = (Outputs & OUTPUT_FIELD) != 0;
+    const bool wantG = (Outputs & OUTPUT_GRADIENT) != 0;
+    // V, Ex, Ey, Ez, Gxx, Gyy, Gzz, Gxy, Gxz, Gyz of every point
+    double sums[P][10];
+    for (int p = 0; p < P; ++p) {
+        for (int j = 0; j < 10; ++j) {
+            sums[p][j] = 0.0;
+        }
+    }
+    std::size_t i = begin;
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+#if defined(__AVX512F__)
+    typedef __m512d vec;
+    const std::size_t lanes = 8;
+#define TERMS_SET1 _mm512_set1_pd
+#define TERMS_LOAD _mm512_loadu_pd
+#define TERMS_ADD _mm512_add_pd
+#define TERMS_SUB _mm512_sub_pd
+#define TERMS_MUL _mm512_mul_pd
+#define TERMS_FMADD _mm512_fmadd_pd
+#define TERMS_FNMADD _mm512_fnmadd_pd
+#define TERMS_REDUCE _mm512_reduce_add_pd
+#else
+    typedef __m256d vec;
+    const std::size_t lanes = 4;
+#define TERMS_SET1 _mm256_set1_pd
+#define TERMS_LOAD _mm256_loadu_pd
+#define TERMS_ADD _mm256_add_pd
+#define TERMS_SUB _mm256_sub_pd
+#define TERMS_MUL _mm256_mul_pd
+#define TERMS_FMADD _mm256_fmadd_pd
+#define TERMS_FNMADD _mm256_fnmadd_pd
+#define TERMS_REDUCE horizontalSum
+#endif
+    vec acc[P][10];
+    for (int p = 0; p < P; ++p) {
+        for (int j = 0; j < 10; ++j) {
+            acc[p][j] = TERMS_SET1(0.0);
+        }
+    }
+    const vec three = TERMS_SET1(3.0);
+    const vec eps2 = TERMS_SET1(softening2);
+
+    for (; i + lanes <= end; i += lanes) {
+        const vec cx = TERMS_LOAD(xs + i);
+        const vec cy = TERMS_LOAD(ys + i);
+        const vec cz = TERMS_LOAD(zs + i);
+        const vec cq = TERMS_LOAD(qs + i);
+        for (int p = 0; p < P; ++p) {
+            vec dx = TERMS_SUB(TERMS_SET1(pts[p].x), cx);
+            vec dy = TERMS_SUB(TERMS_SET1(pts[p].y), cy);
+            vec dz = TERMS_SUB(TERMS_SET1(pts[p].z), cz);
+            vec r_squared = TERMS_FMADD(dx, dx, TERMS_FMADD(dy, dy, TERMS_FMADD(dz, dz, eps2)));
+#if defined(__AVX512F__)
+            vec inv_r = reciprocalSqrt(r_squared);
+#else
+            vec inv_r = _mm256_div_pd(TERMS_SET1(1.0), _mm256_sqrt_pd(r_squared));
+#endif
+            vec q_r = TERMS_MUL(cq, inv_r);
+            if (wantV) {
+                acc[p][0] = TERMS_ADD(acc[p][0], q_r);
+            }
+            if (wantE || wantG) {
+                vec inv_r2 = TERMS_MUL(inv_r, inv_r);
+                vec q_r3 = TERMS_MUL(q_r, inv_r2);
+                if (wantE) {
+                    acc[p][1] = TERMS_FMADD(q_r3, dx, acc[p][1]);
+                    acc[p][2] = TERMS_FMADD(q_r3, dy, acc[p][2]);
+                    acc[p][3] = TERMS_FMADD(q_r3, dz, acc[p][3]);
+                }
+                if (wantG) {
+                    vec q3_r5 = TERMS_MUL(three, TERMS_MUL(q_r3, inv_r2));
+                    vec tx = TERMS_MUL(q3_r5, dx);
+                    vec ty = TERMS_MUL(q3_r5, dy);
+                    vec tz = TERMS_MUL(q3_r5, dz);
+                    acc[p][4] = TERMS_FNMADD(tx, dx, TERMS_ADD(acc[p][4], q_r3));
+                    acc[p][5] = TERMS_FNMADD(ty, dy, TERMS_ADD(acc[p][5], q_r3));
+                    acc[p][6] = TERMS_FNMADD(tz, dz, TERMS_ADD(acc[p][6], q_r3));
+                    acc[p][7] = TERMS_FNMADD(tx, dy, acc[p][7]);
+                    acc[p][8] = TERMS_FNMADD(tx, dz, acc[p][8]);
+                    acc[p][9] = TERMS_FNMADD(ty, dz, acc[p][9]);
+                }
+            }
+        }
+    }
+    for (int p = 0; p < P; ++p) {
+        for (int j = 0; j < 10; ++j) {
+            sums[p][j] = TERMS_REDUCE(acc[p][j]);
+        }
+    }
+#undef TERMS_SET1
+#undef TERMS_LOAD
+#undef TERMS_ADD
+#undef TERMS_SUB
+#undef TERMS_MUL
+#undef TERMS_FMADD
+#undef TERMS_FNMADD
+#undef TERMS_REDUCE
+#endif
+
+    for (; i < end; ++i) {
+        for (int p = 0; p < P; ++p) {
+            double dx = pts[p].x - xs[i];
+            double dy = pts[p].y - ys[i];
+            double dz = pts[p].z - zs[i];
+            double r_squared = dx * dx + dy * dy + dz * dz + softening2;
+            double inv_r = 1.0 / std::sqrt(r_squared);
+            double q_r = qs[i] * inv_r;
+            double inv_r2 = inv_r * inv_r;
+            double q_r3 = q_r * inv_r2;
+            double q3_r5 = 3.0 * q_r3 * inv_r2;
+            sums[p][0] += q_r;
+            sums[p][1] += q_r3 * dx;
+            sums[p][2] += q_r3 * dy;
+            sums[p][3] += q_r3 * dz;
+            sums[p][4] += q_r3 - q3_r5 * dx * dx;
+            sums[p][5] += q_r3 - q3_r5 * dy * dy;
+            sums[p][6] += q_r3 - q3_r5 * dz * dz;
+            sums[p][7] -= q3_r5 * dx * dy;
+            sums[p][8] -= q3_r5 * dx * dz;
+            sums[p][9] -= q3_r5 * dy * dz;
+        }
+    }
+
+    for (int p = 0; p < P; ++p) {
+        if (wantV) {
+            out[p].V += sums[p][0];
+        }
+        if (wantE) {
+            out[p].Ex += sums[p][1];
+            out[p].Ey += sums[p][2];
+            out[p].Ez += sums[p][3];
+        }
+        if (wantG) {
+            out[p].Gxx += sums[p][4];
+            out[p].Gyy += sums[p][5];
+            out[p].Gzz += sums[p][6];
+            out[p].Gxy += sums[p][7];
+            out[p].Gxz += sums[p][8];
+            out[p].Gyz += sums[p][9];
+        }
+    }
+}
+
+/**
+ * Adds the terms of the charges [begin, end) at m points to out, a block of points at a time.
+ *
+ * @param xs, ys, zs, qs    The charge arrays, q in Coulomb.
+ * @param begin             Index of the first charge to include.
+ * @param end               One past the index of the last charge to include.
+ * @param pts               The query points.
+ * @param m                 The number of query points.
+ * @param out               The m sets of terms to accumulate into.
+ * @param softening2        The squared softening length, 0 for the exact Coulomb terms.
+ */
+template <unsigned Outputs>
+inline void accumulateTermsTile(const double* xs, const double* ys, const double* zs, const double* qs,
+                                std::size_t begin, std::size_t end, const Point* pts, std::size_t m,
+                                FieldTerms* out, double softening2) {
+    const int block = TermsBlock<Outputs>::points;
+    std::size_t p = 0;
+    for (; p + block <= m; p += block) {
+        accumulateTerms<Outputs, block>(xs, ys, zs, qs, begin, end, pts + p, out + p, softening2);
+    }
+    for (; p < m; ++p) {
+        accumulateTerms<Outputs, 1>(xs, ys, zs, qs, begin, end, pts + p, out + p, softening2);
+    }
+}
+
+/**
+ * Adds one set of terms to another.
+ *
+ * @param out       The terms to add to.
+ * @param other     The terms to add.
+ */
+inline void addTerms(FieldTerms& out, const FieldTerms& other) {
+    out.V += other.V;
+    out.Ex += other.Ex;
+    out.Ey += other.Ey;
+    out.Ez += other.Ez;
+    out.Gxx += other.Gxx;
+    out.Gyy += other.Gyy;
+    out.Gzz += other.Gzz;
+    out.Gxy += other.Gxy;
+    out.Gxz += other.Gxz;
+    out.Gyz += other.Gyz;
+}
+
+/**
+ * Evaluates the selected terms of all charges at a batch of points, tiled and
+ * split over the OpenMP threads the same way as ECE_ChargeArray::evaluateField.
+ *
+ * @param charges   The charges.
+ * @param pts       The query points.
+ * @param m         The number of query points.
+ * @param out       Array of m entries receiving the terms at each point.
+ * @param softening The softening length eps in meters, 0 for the exact Coulomb terms.
+ */
+template <unsigned Outputs>
+void evaluateTerms(const ECE_ChargeArray& charges, const Point* pts, std::size_t m, FieldTerms* out,
+                   double softening = 0.0) {
+    const double* xs = charges.xData();
+    const double* ys = charges.yData();
+    const double* zs = charges.zData();
+    const double* qs = charges.qData();
+    const std::size_t n = charges.size();
+    const std::size_t chargeTile = ECE_ChargeArray::CHARGE_TILE;
+    const std::size_t pointTile = ECE_ChargeArray::POINT_TILE;
+    const long numPointTiles = long((m + pointTile - 1) / pointTile);
+    const int maxThreads = omp_get_max_threads();
+    const FieldTerms zero = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    const double softening2 = softening * softening;
+
+    std::fill(out, out + m, zero);
+
+    if (charges.isDeterministic() && n > 0) {
+        // The tile sums of ECE_ChargeArray::evaluateField's deterministic mode, with one task per point tile
+        const std::size_t numChargeTiles = (n + chargeTile - 1) / chargeTile;
+        auto add = [](FieldTerms& a, const FieldTerms& b) { addTerms(a, b); };
+        #pragma omp parallel
+        #pragma omp single
+        for (long t = 0; t < numPointTiles; ++t) {
+            std::size_t p0 = t * pointTile;
+            std::size_t p1 = std::min(m, p0 + pointTile);
+            auto accumulate = [&, p0, p1](std::size_t c, FieldTerms* tileOut) {
+                accumulateTermsTile<Outputs>(xs, ys, zs, qs, c * chargeTile, std::min(n, (c + 1) * chargeTile),
+                                             pts + p0, p1 - p0, tileOut, softening2);
+            };
+            #pragma omp task firstprivate(p0, p1, accumulate)
+            pairwiseBlockSum(0, numChargeTiles, p1 - p0, zero, out + p0, accumulate, add, true);
+        }
+    } else if (numPointTiles >= maxThreads) {
+        // Enough points: each thread owns whole point tiles and sweeps all charge tiles over them
+        #pragma omp parallel for schedule(dynamic)
+        for (long t = 0; t < numPointTiles; ++t) {
+            std::size_t p0 = t * pointTile;
+            std::size_t p1 = std::min(m, p0 + pointTile);
+            for (std::size_t c0 = 0; c0 < n; c0 += chargeTile) {
+                std::size_t c1 = std::min(n, c0 + chargeTile);
+                accumulateTermsTile<Outputs>(xs, ys, zs, qs, c0, c1, pts + p0, p1 - p0, out + p0, softening2);
+            }
+        }
+    } else {
+        // Few points: split the charges over the threads and merge private results in thread order
+        std::vector<FieldTerms> partial(std::size_t(maxThreads) * m, zero);
+        #pragma omp parallel
+        {
+            int id = omp_get_thread_num();
+            int numThreads = omp_get_num_threads();
+            std::size_t begin = n * id / numThreads;
+            std::size_t end = n * (id + 1) / numThreads;
+            FieldTerms* mine = &partial[std::size_t(id) * m];
+            for (std::size_t c0 = begin; c0 < end; c0 += chargeTile) {
+                std::size_t c1 = std::min(end, c0 + chargeTile);
+                for (std::size_t p0 = 0; p0 < m; p0 += pointTile) {
+                    std::size_t p1 = std::min(m, p0 + pointTile);
+                    accumulateTermsTile<Outputs>(xs, ys, zs, qs, c0, c1, pts + p0, p1 - p0, mine + p0, softening2);
+                }
+            }
+        }
+        for (int id = 0; id < maxThreads; ++id) {
+            for (std::size_t p = 0; p < m; ++p) {
+                addTerms(out[p], partial[std::size_t(id) * m + p]);
+            }
+        }
+    }
+
+    const double k = ECE_ChargeArray::k;
+    for (std::size_t p = 0; p < m; ++p) {
+        FieldTerms& t = out[p];
+        t.V *= k;
+        t.Ex *= k;
+        t.Ey *= k;
+        t.Ez *= k;
+        t.Gxx *= k;
+        t.Gyy *= k;
+        t.Gzz *= k;
+        t.Gxy *= k;
+        t.Gxz *= k;
+        t.Gyz *= k;
+    }
+}
+
+#endif // ECE_FIELDTERMS_H
@@ -0,0 +1,192 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_FieldVolume class.
+The nodes are computed one z layer at a time with the batched kernel of
+ECE_ChargeArray, which spreads every layer over the OpenMP threads.
+
+*/
+
+#include "ECE_FieldVolume.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+ECE_FieldVolume::ECE_FieldVolume(const ECE_ChargeArray& charges)
+    : charges(charges), x0(0.0), y0(0.0), dx(0.0), dy(0.0), nx(0), ny(0), nz(0), zScale(0.0), u0(0.0), du(0.0) {}
+
+double ECE_FieldVolume::zToU(double z) const {
+    return zScale > 0.0 ? std::asinh(z / zScale) : z;
+}
+
+void ECE_FieldVolume::build(double xMin, double xMax, double yMin, double yMax, double zMin, double zMax,
+                            int nx, int ny, int nz, double zScale) {
+    this->nx = std::max(nx, 2);
+    this->ny = std::max(ny, 2);
+    this->nz = std::max(nz, 2);
+    this->zScale = std::max(zScale, 0.0);
+    x0 = xMin;
+    y0 = yMin;
+    dx = (xMax - xMin) / (this->nx - 1);
+    dy = (yMax - yMin) / (this->ny - 1);
+    u0 = zToU(zMin);
+    du = (zToU(zMax) - u0) / (this->nz - 1);
+
+    zNodes.resize(this->nz);
+    for (int k = 0; k < this->nz; ++k) {
+        double u = u0 + k * du;
+        zNodes[k] = this->zScale > 0.0 ? this->zScale * std::sinh(u) : u;
+    }
+    zNodes.front() = zMin;
+    zNodes.back() = zMax;
+    // A layer meant for the charge plane is put exactly on it, so that both of its cells use the direct sum
+    for (double& z : zNodes) {
+        if (std::fabs(z) <= 1e-9 * (zMax - zMin)) {
+            z = 0.0;
+        }
+    }
+
+    // One layer of nodes per batched query
+    const std::size_t layerSize = std::size_t(this->nx) * this->ny;
+    nodes.resize(layerSize * this->nz);
+    std::vector<Point> layer(layerSize);
+    for (int k = 0; k < this->nz; ++k) {
+        for (int j = 0; j < this->ny; ++j) {
+            for (int i = 0; i < this->nx; ++i) {
+                layer[std::size_t(j) * this->nx + i] = Point{x0 + i * dx, y0 + j * dy, zNodes[k]};
+            }
+        }
+        charges.evaluateField(layer.data(), layerSize, &nodes[k * layerSize]);
+    }
+}
+
+bool ECE_FieldVolume::interpolate(double x, double y, double z, Field& out) const {
+    const double fx = (x - x0) / dx;
+    const double fy = (y - y0) / dy;
+    if (!(fx >= 0.0 && fx <= nx - 1 && fy >= 0.0 && fy <= ny - 1 && z >= zNodes.front() && z <= zNodes.back())) {
+        return false;
+    }
+    const int i = std::min(int(fx), nx - 2);
+    const int j = std::min(int(fy), ny - 2);
+    // The layer from the inverse grading, corrected for rounding at the layer boundaries
+    int k = std::min(std::max(int((zToU(z) - u0) / du), 0), nz - 2);
+    while (k > 0 && z < zNodes[k]) {
+        --k;
+    }
+    while (k < nz - 2 && z > zNodes[k + 1]) {
+        ++k;
+    }
+    // The field is singular on the charge plane, so the cells that touch it are left to the direct sum
+    if (zNodes[k] <= 0.0 && zNodes[k + 1] >= 0.0) {
+        return false;
+    }
+    const double wx = fx - i;
+    const double wy = fy - j;
+    const double wz = (z - zNodes[k]) / (zNodes[k + 1] - zNodes[k]);
+
+    const std::size_t sx = 1, sy = std::size_t(nx), sz = std::size_t(nx) * ny;
+    const Field* c = &nodes[k * sz + j * sy + i];
+    const double w[8] = {(1 - wx) * (1 - wy) * (1 - wz), wx * (1 - wy) * (1 - wz),
+                         (1 - wx) * wy * (1 - wz),       wx * wy * (1 - wz),
+                         (1 - wx) * (1 - wy) * wz,       wx * (1 - wy) * wz,
+                         (1 - wx) * wy * wz,             wx * wy * wz};
+    const std::size_t offsets[8] = {0, sx, sy, sx + sy, sz, sz + sx, sz + sy, sz + sx + sy};
+    out = Field{0.0, 0.0, 0.0};
+    for (int n = 0; n < 8; ++n) {
+        out.Ex += w[n] * c[offsets[n]].Ex;
+        out.Ey += w[n] * c[offsets[n]].Ey;
+        out.Ez += w[n] * c[offsets[n]].Ez;
+    }
+    return true;
+}
+
+double ECE_FieldVolume::estimateError(std::size_t samples) const {
+    std::mt19937 rng(12345);
+    std::vector<Point> centres(samples);
+    for (Point& p : centres) {
+        const int i = int(rng() % unsigned(nx - 1));
+        const int j = int(rng() % unsigned(ny - 1));
+        const int k = int(rng() % unsigned(nz - 1));
+        p = Point{x0 + (i + 0.5) * dx, y0 + (j + 0.5) * dy, 0.5 * (zNodes[k] + zNodes[k + 1])};
+    }
+    std::vector<Field> exact(samples);
+    charges.evaluateField(centres.data(), samples, exact.data());
+
+    double maxError = 0.0;
+    for (std::size_t s = 0; s < samples; ++s) {
+        Field approx;
+        if (!interpolate(centres[s].x, centres[s].y, centres[s].z, approx)) {
+            continue;   // a cell on the charge plane, answered exactly
+        }
+        const Field& E = exact[s];
+        double norm = std::sqrt(E.Ex * E.Ex + E.Ey * E.Ey + E.Ez * E.Ez);
+        double err = std::sqrt((approx.Ex - E.Ex) * (approx.Ex - E.Ex) + (approx.Ey - E.Ey) * (approx.Ey - E.Ey)
+                               + (approx.Ez - E.Ez) * (approx.Ez - E.Ez));
+        if (!std::isfinite(err)) {
+            return INFINITY;    // an interpolated value is not finite; never hide it behind the comparison
+        }
+        if (norm > 0.0) {
+            maxError = std::max(maxError, err / norm);
+        }
+    }
+    return maxError;
+}
+
+void ECE_FieldVolume::computeFieldAt(double x, double y, double z, double &Ex, double &Ey, double &Ez) const {
+    Field E;
+    if (!interpolate(x, y, z, E)) {
+        Point p = {x, y, z};
+        charges.evaluateField(&p, 1, &E);
+    }
+    Ex = E.Ex;
+    Ey = E.Ey;
+    Ez = E.Ez;
+}
+
+std::size_t ECE_FieldVolume::evaluateField(const Point* pts, std::size_t m, Field* out) const {
+    std::vector<char> inside(m);
+    #pragma omp parallel for schedule(static)
+    for (long p = 0; p < long(m); ++p) {
+        inside[p] = interpolate(pts[p].x, pts[p].y, pts[p].z, out[p]);
+    }
+
+    // The points outside the box go through the direct sum in one batch
+    std::vector<std::size_t> outside;
+    for (std::size_t p = 0; p < m; ++p) {
+        if (!inside[p]) {
+            outside.push_back(p);
+        }
+    }
+    if (!outside.empty()) {
+        std::vector<Point> farPoints(outside.size());
+        std::vector<Field> farFields(outside.size());
+        for (std::size_t n = 0; n < outside.size(); ++n) {
+            farPoints[n] = pts[outside[n]];
+        }
+        charges.evaluateField(farPoints.data(), farPoints.size(), farFields.data());
+        for (std::size_t n = 0; n < outside.size(); ++n) {
+            out[outside[n]] = farFields[n];
+        }
+    }
+    return outside.size();
+}
+
+double ECE_FieldVolume::getMinZSpacing() const {
+    double spacing = zNodes.back() - zNodes.front();
+    for (int k = 0; k + 1 < nz; ++k) {
+        spacing = std::min(spacing, zNodes[k + 1] - zNodes[k]);
+    }
+    return spacing;
+}
+
+double ECE_FieldVolume::getMaxZSpacing() const {
+    double spacing = 0.0;
+    for (int k = 0; k + 1 < nz; ++k) {
+        spacing = std::max(spacing, zNodes[k + 1] - zNodes[k]);
+    }
+    return spacing;
+}
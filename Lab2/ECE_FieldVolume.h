@@ -0,0 +1,116 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_FieldVolume class.
+This class precomputes the field of an ECE_ChargeArray on the nodes of a
+box-shaped grid once, with the batched OpenMP kernel, and then answers
+queries inside the box by trilinear interpolation of the 8 surrounding
+nodes in O(1) instead of summing over all N charges. Queries outside the
+box fall back to the direct sum, as do queries in the cells that touch the
+charge plane z = 0, where the field is singular and the volume has no
+softening to smooth it.
+
+The field above a charge plane changes on a length scale of about the
+height z, so the z nodes are graded towards the plane z = 0:
+    z = s sinh(u), u uniform,
+which gives a spacing of about sqrt(s^2 + z^2) du, i.e. a constant ratio
+of spacing to height away from the plane. s is the grading scale; s = 0
+spaces the z nodes uniformly.
+
+The trilinear error of a cell with sides hx, hy, hz is at most
+    (hx^2 |d2E/dx2| + hy^2 |d2E/dy2| + hz^2 |d2E/dz2|) / 8,
+which the class estimates after the build by comparing the interpolated
+field to the direct sum at the centres of sampled cells, where the
+trilinear error is largest.
+
+*/
+
+#ifndef ECE_FIELDVOLUME_H
+#define ECE_FIELDVOLUME_H
+
+#include "ECE_ChargeArray.h"
+#include <cstddef>
+#include <vector>
+
+class ECE_FieldVolume {
+protected:
+    const ECE_ChargeArray& charges; // the charges, used for the build and for queries outside the box
+    double x0, y0;                  // lower corner of the box in x and y
+    double dx, dy;                  // node spacing in x and y
+    int nx, ny, nz;                 // number of nodes along each axis
+    double zScale;                  // grading scale s, 0 for uniform z nodes
+    double u0, du;                  // z nodes at s sinh(u0 + k du), or u0 + k du when uniform
+    std::vector<double> zNodes;     // z of every node layer
+    std::vector<Field> nodes;       // field at the nodes, x fastest, then y, then z
+
+    double zToU(double z) const;
+    bool interpolate(double x, double y, double z, Field& out) const;
+
+public:
+    /**
+     * @brief Constructor for ECE_FieldVolume class. The volume is empty until build is called.
+     *
+     * @param charges The charges; they must stay alive and unchanged while the volume is used.
+     */
+    explicit ECE_FieldVolume(const ECE_ChargeArray& charges);
+    /**
+     * @brief Compute the field at the nodes of a grid covering a box.
+     *
+     * @param xMin The lower x limit of the box.
+     * @param xMax The upper x limit of the box.
+     * @param yMin The lower y limit of the box.
+     * @param yMax The upper y limit of the box.
+     * @param zMin The lower z limit of the box.
+     * @param zMax The upper z limit of the box.
+     * @param nx The number of nodes in the x-direction, at least 2.
+     * @param ny The number of nodes in the y-direction, at least 2.
+     * @param nz The number of nodes in the z-direction, at least 2.
+     * @param zScale The grading scale s of the z nodes towards z = 0, 0 for uniform nodes.
+     */
+    void build(double xMin, double xMax, double yMin, double yMax, double zMin, double zMax,
+               int nx, int ny, int nz, double zScale);
+    /**
+     * @brief Estimate the interpolation error at the centres of sampled cells.
+     *
+     * @param samples The number of cells to sample.
+     * @return The largest error relative to the field magnitude at the sampled centres,
+     *         infinity if an interpolated field is not finite.
+     */
+    double estimateError(std::size_t samples) const;
+    /**
+     * @brief Compute the electric field at a point, interpolated inside the box away from the charge plane.
+     *
+     * @param x The x-coordinate of the point.
+     * @param y The y-coordinate of the point.
+     * @param z The z-coordinate of the point.
+     * @param Ex Reference to store the electric field in the x-direction.
+     * @param Ey Reference to store the electric field in the y-direction.
+     * @param Ez Reference to store the electric field in the z-direction.
+     */
+    void computeFieldAt(double x, double y, double z, double &Ex, double &Ey, double &Ez) const;
+    /**
+     * @brief Compute the electric field at many points, interpolated inside the box.
+     *
+     * @param pts The query points.
+     * @param m The number of points.
+     * @param out Array of m fields to store the results.
+     * @return The number of points outside the box or in a cell on the charge plane, answered with the direct sum.
+     */
+    std::size_t evaluateField(const Point* pts, std::size_t m, Field* out) const;
+
+    /**
+     * @brief Get the number of nodes of the grid.
+     */
+    std::size_t getNodeCount() const { return nodes.size(); }
+    /**
+     * @brief Get the smallest and largest z spacing of the grid.
+     */
+    double getMinZSpacing() const;
+    double getMaxZSpacing() const;
+};
+
+#endif // ECE_FIELDVOLUME_H
@@ -0,0 +1,372 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header-only field kernel for charges on a regular rows x cols lattice, the
+layout that main.cpp generates. Charge n sits in row n / cols and column
+n % cols, at x0 + column * xSeparation, y0 + row * ySeparation, so the kernel
+generates x and y from the indices in registers instead of loading them.
+Two properties of the lattice are template parameters, selected at compile
+time and dispatched once per query:
+
+    UniformQ    every charge has the same q, which multiplies the sums at
+                the end instead of every term, and the q array is not read
+    Planar      every charge has the same z, so dz is a constant of the
+                query point and the z array is not read
+
+With both (the lattice of main.cpp) no charge memory is streamed at all and
+the query is bound by the arithmetic of 1/r^3 alone. The other three
+instantiations still read the z and/or q arrays.
+
+*/
+
+#ifndef ECE_LATTICEKERNEL_H
+#define ECE_LATTICEKERNEL_H
+
+#include "ECE_ChargeArray.h"
+#include "ECE_PairwiseSum.h"
+#include "ECE_SimdMath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include <omp.h>
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX512F__)
+static const int LATTICE_POINT_BLOCK = 4; // 4 points x 3 accumulators fit in the 32 zmm registers
+#else
+static const int LATTICE_POINT_BLOCK = 2; // 2 points x 3 accumulators fit in the 16 ymm registers
+#endif
+
+/**
+ * Adds the field of the lattice charges [begin, end) at P points to out, without the Coulomb constant.
+ * The row and column of every lane are kept in registers as exact integers in double and
+ * advanced by the vector width, wrapping to the next row at the end of a row.
+ *
+ * @param lattice   The lattice geometry.
+ * @param zs, qs    The z and q arrays, only read when the lattice is not planar or not uniform.
+ * @param begin     Index of the first charge to include.
+ * @param end       One past the index of the last charge to include.
+ * @param pts       The P query points.
+ * @param out       The P fields to accumulate into.
+ */
+template <bool UniformQ, bool Planar, int P>
+inline void accumulateLattice(const LatticeGeometry& lattice, const double* zs, const double* qs,
+                              std::size_t begin, std::size_t end, const Point* pts, Field* out) {
+    const std::size_t cols = lattice.cols;
+    // Points relative to the charge in row 0, column 0 (and to the plane when planar)
+    double px[P], py[P], pz[P];
+    double sumEx[P], sumEy[P], sumEz[P];
+    for (int p = 0; p < P; ++p) {
+        px[p] = pts[p].x - lattice.x0;
+        py[p] = pts[p].y - lattice.y0;
+        pz[p] = Planar ? pts[p].z - lattice.z : pts[p].z;
+        sumEx[p] = 0.0;
+        sumEy[p] = 0.0;
+        sumEz[p] = 0.0;
+    }
+    std::size_t n = begin;
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+#if defined(__AVX512F__)
+    typedef __m512d vec;
+    const std::size_t lanes = 8;
+    vec column = _mm512_set_pd(7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.0);
+#define LATTICE_SET1 _mm512_set1_pd
+#define LATTICE_LOAD _mm512_loadu_pd
+#define LATTICE_ADD _mm512_add_pd
+#define LATTICE_SUB _mm512_sub_pd
+#define LATTICE_MUL _mm512_mul_pd
+#define LATTICE_FMADD _mm512_fmadd_pd
+#define LATTICE_REDUCE _mm512_reduce_add_pd
+#define LATTICE_INV_R_CUBED(r_squared, inv_r3) do { \
+        vec inv_r = reciprocalSqrt(r_squared); \
+        inv_r3 = _mm512_mul_pd(inv_r, _mm512_mul_pd(inv_r, inv_r)); \
+    } while (0)
+#define LATTICE_WRAP() do { \
+        __mmask8 wrap = _mm512_cmp_pd_mask(column, numCols, _CMP_GE_OQ); \
+        while (wrap) { \
+            column = _mm512_mask_sub_pd(column, wrap, column, numCols); \
+            row = _mm512_mask_add_pd(row, wrap, row, one); \
+            wrap = _mm512_cmp_pd_mask(column, numCols, _CMP_GE_OQ); \
+        } \
+    } while (0)
+#else
+    typedef __m256d vec;
+    const std::size_t lanes = 4;
+    vec column = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+#define LATTICE_SET1 _mm256_set1_pd
+#define LATTICE_LOAD _mm256_loadu_pd
+#define LATTICE_ADD _mm256_add_pd
+#define LATTICE_SUB _mm256_sub_pd
+#define LATTICE_MUL _mm256_mul_pd
+#define LATTICE_FMADD _mm256_fmadd_pd
+#define LATTICE_REDUCE horizontalSum
+#define LATTICE_INV_R_CUBED(r_squared, inv_r3) do { \
+        inv_r3 = _mm256_div_pd(one, _mm256_mul_pd(_mm256_sqrt_pd(r_squared), r_squared)); \
+    } while (0)
+#define LATTICE_WRAP() do { \
+        vec wrap = _mm256_cmp_pd(column, numCols, _CMP_GE_OQ); \
+        while (_mm256_movemask_pd(wrap)) { \
+            column = _mm256_sub_pd(column, _mm256_and_pd(wrap, numCols)); \
+            row = _mm256_add_pd(row, _mm256_and_pd(wrap, one)); \
+            wrap = _mm256_cmp_pd(column, numCols, _CMP_GE_OQ); \
+        } \
+    } while (0)
+#endif
+    const vec one = LATTICE_SET1(1.0);
+    const vec numCols = LATTICE_SET1(double(cols));
+    const vec xSeparation = LATTICE_SET1(lattice.xSeparation);
+    const vec ySeparation = LATTICE_SET1(lattice.ySeparation);
+    const vec step = LATTICE_SET1(double(lanes));
+    vec accX[P], accY[P], accZ[P];
+    for (int p = 0; p < P; ++p) {
+        accX[p] = LATTICE_SET1(0.0);
+        accY[p] = LATTICE_SET1(0.0);
+        accZ[p] = LATTICE_SET1(0.0);
+    }
+
+    if (n + lanes <= end) {
+        column = LATTICE_ADD(column, LATTICE_SET1(double(n % cols)));
+        vec row = LATTICE_SET1(double(n / cols));
+        LATTICE_WRAP();
+        for (; n + lanes <= end; n += lanes) {
+            const vec cx = LATTICE_MUL(column, xSeparation);
+            const vec cy = LATTICE_MUL(row, ySeparation);
+            vec cz = LATTICE_SET1(0.0), cq = cz;
+            if (!Planar) {
+                cz = LATTICE_LOAD(zs + n);
+            }
+            if (!UniformQ) {
+                cq = LATTICE_LOAD(qs + n);
+            }
+            for (int p = 0; p < P; ++p) {
+                vec dx = LATTICE_SUB(LATTICE_SET1(px[p]), cx);
+                vec dy = LATTICE_SUB(LATTICE_SET1(py[p]), cy);
+                vec dz = Planar ? LATTICE_SET1(pz[p]) : LATTICE_SUB(LATTICE_SET1(pz[p]), cz);
+                vec r_squared = LATTICE_FMADD(dx, dx, LATTICE_FMADD(dy, dy, LATTICE_MUL(dz, dz)));
+                vec scale;
+                LATTICE_INV_R_CUBED(r_squared, scale);
+                if (!UniformQ) {
+                    scale = LATTICE_MUL(cq, scale);
+                }
+
+                accX[p] = LATTICE_FMADD(scale, dx, accX[p]);
+                accY[p] = LATTICE_FMADD(scale, dy, accY[p]);
+                // dz is the same for every charge of a planar lattice and multiplies the sum at the end
+                accZ[p] = Planar ? LATTICE_ADD(scale, accZ[p]) : LATTICE_FMADD(scale, dz, accZ[p]);
+            }
+            column = LATTICE_ADD(column, step);
+            LATTICE_WRAP();
+        }
+    }
+    for (int p = 0; p < P; ++p) {
+        sumEx[p] = LATTICE_REDUCE(accX[p]);
+        sumEy[p] = LATTICE_REDUCE(accY[p]);
+        sumEz[p] = LATTICE_REDUCE(accZ[p]);
+    }
+#undef LATTICE_SET1
+#undef LATTICE_LOAD
+#undef LATTICE_ADD
+#undef LATTICE_SUB
+#undef LATTICE_MUL
+#undef LATTICE_FMADD
+#undef LATTICE_REDUCE
+#undef LATTICE_INV_R_CUBED
+#undef LATTICE_WRAP
+#endif
+
+    for (; n < end; ++n) {
+        const double cx = double(n % cols) * lattice.xSeparation;
+        const double cy = double(n / cols) * lattice.ySeparation;
+        for (int p = 0; p < P; ++p) {
+            double dx = px[p] - cx;
+            double dy = py[p] - cy;
+            double dz = Planar ? pz[p] : pz[p] - zs[n];
+
+            double r_squared = dx * dx + dy * dy + dz * dz;
+            double scale = 1.0 / (std::sqrt(r_squared) * r_squared);
+            if (!UniformQ) {
+                scale *= qs[n];
+            }
+
+            sumEx[p] += scale * dx;
+            sumEy[p] += scale * dy;
+            sumEz[p] += Planar ? scale : scale * dz;
+        }
+    }
+
+    const double q = UniformQ ? lattice.q : 1.0;
+    for (int p = 0; p < P; ++p) {
+        out[p].Ex += q * sumEx[p];
+        out[p].Ey += q * sumEy[p];
+        out[p].Ez += q * (Planar ? pz[p] * sumEz[p] : sumEz[p]);
+    }
+}
+
+/**
+ * Adds the field of the lattice charges [begin, end) at m points to out,
+ * LATTICE_POINT_BLOCK points at a time, without the Coulomb constant.
+ *
+ * @param lattice   The lattice geometry.
+ * @param zs, qs    The z and q arrays.
+ * @param begin     Index of the first charge to include.
+ * @param end       One past the index of the last charge to include.
+ * @param pts       The query points.
+ * @param m         The number of query points.
+ * @param out       The m fields to accumulate into.
+ */
+template <bool UniformQ, bool Planar>
+inline void accumulateLatticeTile(const LatticeGeometry& lattice, const double* zs, const double* qs,
+                                  std::size_t begin, std::size_t end, const Point* pts, std::size_t m,
+                                  Field* out) {
+    std::size_t p = 0;
+    for (; p + LATTICE_POINT_BLOCK <= m; p += LATTICE_POINT_BLOCK) {
+        accumulateLattice<UniformQ, Planar, LATTICE_POINT_BLOCK>(lattice, zs, qs, begin, end, pts + p, out + p);
+    }
+    for (; p < m; ++p) {
+        accumulateLattice<UniformQ, Planar, 1>(lattice, zs, qs, begin, end, pts + p, out + p);
+    }
+}
+
+/**
+ * Evaluates the field of all lattice charges at a batch of points, split over
+ * the OpenMP threads the same way as ECE_ChargeArray::evaluateField. There is
+ * no charge tile to keep in cache, so a thread sweeps all of its charges over
+ * a point tile at once. The deterministic reduction instead cuts the lattice
+ * into blocks of whole rows, about CHARGE_TILE charges each, and adds them
+ * with the pairwise tree of ECE_PairwiseSum.h.
+ *
+ * @param lattice       The lattice geometry.
+ * @param zs, qs        The z and q arrays.
+ * @param n             The number of charges, rows * cols.
+ * @param pts           The query points.
+ * @param m             The number of query points.
+ * @param out           Array of m entries receiving the field at each point.
+ * @param deterministic True for the result that does not depend on the thread count.
+ */
+template <bool UniformQ, bool Planar>
+void evaluateLatticeField(const LatticeGeometry& lattice, const double* zs, const double* qs, std::size_t n,
+                          const Point* pts, std::size_t m, Field* out, bool deterministic) {
+    const std::size_t pointTile = ECE_ChargeArray::POINT_TILE;
+    const long numPointTiles = long((m + pointTile - 1) / pointTile);
+    const int maxThreads = omp_get_max_threads();
+    const Field zero = {0.0, 0.0, 0.0};
+
+    std::fill(out, out + m, zero);
+
+    if (deterministic && n > 0) {
+        const std::size_t block = std::max<std::size_t>(1, ECE_ChargeArray::CHARGE_TILE / lattice.cols) * lattice.cols;
+        const std::size_t numBlocks = (n + block - 1) / block;
+        auto add = [](Field& a, const Field& b) {
+            a.Ex += b.Ex;
+            a.Ey += b.Ey;
+            a.Ez += b.Ez;
+        };
+        // One task per point tile, and the large subtrees of its tree as further tasks
+        #pragma omp parallel
+        #pragma omp single
+        for (long t = 0; t < numPointTiles; ++t) {
+            std::size_t p0 = t * pointTile;
+            std::size_t p1 = std::min(m, p0 + pointTile);
+            auto accumulate = [&, p0, p1](std::size_t b, Field* tileOut) {
+                accumulateLatticeTile<UniformQ, Planar>(lattice, zs, qs, b * block, std::min(n, (b + 1) * block),
+                                                        pts + p0, p1 - p0, tileOut);
+            };
+            #pragma omp task firstprivate(p0, p1, accumulate)
+            pairwiseBlockSum(0, numBlocks, p1 - p0, zero, out + p0, accumulate, add, true);
+        }
+    } else if (numPointTiles >= maxThreads) {
+        // Enough points: each thread owns whole point tiles and sweeps all charges over them
+        #pragma omp parallel for schedule(dynamic)
+        for (long t = 0; t < numPointTiles; ++t) {
+            std::size_t p0 = t * pointTile;
+            std::size_t p1 = std::min(m, p0 + pointTile);
+            accumulateLatticeTile<UniformQ, Planar>(lattice, zs, qs, 0, n, pts + p0, p1 - p0, out + p0);
+        }
+    } else {
+        // Few points: split the charges over the threads and merge private results in thread order
+        std::vector<Field> partial(std::size_t(maxThreads) * m, zero);
+        #pragma omp parallel
+        {
+            int id = omp_get_thread_num();
+            int numThreads = omp_get_num_threads();
+            std::size_t begin = n * id / numThreads;
+            std::size_t end = n * (id + 1) / numThreads;
+            accumulateLatticeTile<UniformQ, Planar>(lattice, zs, qs, begin, end, pts, m,
+                                                    &partial[std::size_t(id) * m]);
+        }
+        for (int id = 0; id < maxThreads; ++id) {
+            for (std::size_t p = 0; p < m; ++p) {
+                out[p].Ex += partial[std::size_t(id) * m + p].Ex;
+                out[p].Ey += partial[std::size_t(id) * m + p].Ey;
+                out[p].Ez += partial[std::size_t(id) * m + p].Ez;
+            }
+        }
+    }
+
+    const double k = ECE_ChargeArray::k;
+    for (std::size_t p = 0; p < m; ++p) {
+        out[p].Ex *= k;
+        out[p].Ey *= k;
+        out[p].Ez *= k;
+    }
+}
+
+/**
+ * Picks the instantiation of accumulateLatticeTile that matches the lattice.
+ *
+ * @param lattice   The lattice geometry.
+ * @param zs, qs    The z and q arrays.
+ * @param begin     Index of the first charge to include.
+ * @param end       One past the index of the last charge to include.
+ * @param pts       The query points.
+ * @param m         The number of query points.
+ * @param out       The m fields to accumulate into, without the Coulomb constant.
+ */
+inline void accumulateLatticeTile(const LatticeGeometry& lattice, const double* zs, const double* qs,
+                                  std::size_t begin, std::size_t end, const Point* pts, std::size_t m,
+                                  Field* out) {
+    if (lattice.uniformQ && lattice.planar) {
+        accumulateLatticeTile<true, true>(lattice, zs, qs, begin, end, pts, m, out);
+    } else if (lattice.uniformQ) {
+        accumulateLatticeTile<true, false>(lattice, zs, qs, begin, end, pts, m, out);
+    } else if (lattice.planar) {
+        accumulateLatticeTile<false, true>(lattice, zs, qs, begin, end, pts, m, out);
+    } else {
+        accumulateLatticeTile<false, false>(lattice, zs, qs, begin, end, pts, m, out);
+    }
+}
+
+/**
+ * Picks the instantiation of evaluateLatticeField that matches the lattice.
+ *
+ * @param lattice   The lattice geometry.
+ * @param zs, qs    The z and q arrays.
+ * @param n         The number of charges, rows * cols.
+ * @param pts       The query points.
+ * @param m         The number of query points.
+ * @param out       Array of m entries receiving the field at each point.
+ * @param deterministic True for the result that does not depend on the thread count.
+ */
+inline void evaluateLatticeField(const LatticeGeometry& lattice, const double* zs, const double* qs, std::size_t n,
+                                 const Point* pts, std::size_t m, Field* out, bool deterministic = false) {
+    if (lattice.uniformQ && lattice.planar) {
+        evaluateLatticeField<true, true>(lattice, zs, qs, n, pts, m, out, deterministic);
+    } else if (lattice.uniformQ) {
+        evaluateLatticeField<true, false>(lattice, zs, qs, n, pts, m, out, deterministic);
+    } else if (lattice.planar) {
+        evaluateLatticeField<false, true>(lattice, zs, qs, n, pts, m, out, deterministic);
+    } else {
+        evaluateLatticeField<false, false>(lattice, zs, qs, n, pts, m, out, deterministic);
+    }
+}
+
+#endif // ECE_LATTICEKERNEL_H
@@ -0,0 +1,111 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header-only reproducible reduction over the charge tiles of a batched query.
+The default kernels give every thread a charge range that depends on the
+thread count and add the per-thread sums in whatever grouping results, so
+the last bits of a field change with OMP_NUM_THREADS. Here the charges are
+cut into fixed blocks, every block is summed into fresh accumulators, and
+the block sums are combined by a pairwise tree that only depends on the
+number of blocks:
+
+    sum(lo, hi) = block lo                            if hi - lo = 1
+                  sum(lo, mid) + sum(mid, hi)         mid = lo + (hi - lo) / 2
+
+Which thread computes a subtree does not change a single addition, so the
+result is bit-identical for any number of threads. The tree also keeps the
+rounding error at O(log blocks) instead of O(blocks).
+
+*/
+
+#ifndef ECE_PAIRWISESUM_H
+#define ECE_PAIRWISESUM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+static const std::size_t PAIRWISE_TASK_BLOCKS = 8; // smallest subtree handed to another OpenMP task
+
+/**
+ * Counts the scratch rows of m values that the pairwise sum of a number of blocks needs:
+ * every internal node keeps the sum of its upper half in one row. Along a sequential path
+ * the rows of a level are reused, one per level; the two halves of a subtree that runs as
+ * tasks get disjoint ranges, so that they can run at the same time.
+ *
+ * @param blocks        The number of blocks.
+ * @param tasks         True if large subtrees are split into OpenMP tasks.
+ * @return              The number of rows.
+ */
+inline std::size_t pairwiseScratchRows(std::size_t blocks, bool tasks) {
+    if (blocks <= 1) {
+        return 0;
+    }
+    const std::size_t lower = blocks / 2, upper = blocks - lower;
+    if (tasks && blocks >= PAIRWISE_TASK_BLOCKS) {
+        return 1 + pairwiseScratchRows(lower, true) + pairwiseScratchRows(upper, true);
+    }
+    // The upper half is never smaller, so its rows cover the lower half as well
+    return 1 + pairwiseScratchRows(upper, false);
+}
+
+/**
+ * Sums the blocks [lo, hi) into out with the scratch rows laid out by pairwiseScratchRows.
+ *
+ * @param scratch       pairwiseScratchRows(hi - lo, tasks) rows of m values.
+ * The other parameters are those of pairwiseBlockSum.
+ */
+template <typename T, typename Accumulate, typename Add>
+void pairwiseBlockSumInto(std::size_t lo, std::size_t hi, std::size_t m, const T& zero, T* out, T* scratch,
+                          const Accumulate& accumulate, const Add& add, bool tasks) {
+    if (hi - lo == 1) {
+        std::fill(out, out + m, zero);
+        accumulate(lo, out);
+        return;
+    }
+    const std::size_t mid = lo + (hi - lo) / 2;
+    T* upper = scratch;
+    T* rest = scratch + m;
+    if (tasks && hi - lo >= PAIRWISE_TASK_BLOCKS) {
+        T* upperRest = rest + pairwiseScratchRows(mid - lo, true) * m;
+        #pragma omp task firstprivate(mid, hi, upper, upperRest)
+        pairwiseBlockSumInto(mid, hi, m, zero, upper, upperRest, accumulate, add, true);
+        pairwiseBlockSumInto(lo, mid, m, zero, out, rest, accumulate, add, true);
+        #pragma omp taskwait
+    } else {
+        pairwiseBlockSumInto(lo, mid, m, zero, out, rest, accumulate, add, false);
+        pairwiseBlockSumInto(mid, hi, m, zero, upper, rest, accumulate, add, false);
+    }
+    for (std::size_t p = 0; p < m; ++p) {
+        add(out[p], upper[p]);
+    }
+}
+
+/**
+ * Sums the blocks [lo, hi) of m values each with the fixed pairwise tree.
+ * With tasks set, and called from inside an OpenMP single region, the two
+ * halves of large subtrees run as separate tasks. The partial sums of the
+ * whole tree share one scratch buffer, allocated once per call.
+ *
+ * @param lo            Index of the first block.
+ * @param hi            One past the index of the last block.
+ * @param m             The number of values per block, e.g. query points.
+ * @param zero          The value the accumulators of a block start from.
+ * @param out           The m values receiving the sum.
+ * @param accumulate    Called as accumulate(block, out) to add one block to m zeroed values.
+ * @param add           Called as add(a, b) to add value b to value a.
+ * @param tasks         True to split large subtrees into OpenMP tasks.
+ */
+template <typename T, typename Accumulate, typename Add>
+void pairwiseBlockSum(std::size_t lo, std::size_t hi, std::size_t m, const T& zero, T* out,
+                      const Accumulate& accumulate, const Add& add, bool tasks) {
+    // Every task of the tree has finished when the root returns, so the buffer outlives them all
+    std::vector<T> scratch(pairwiseScratchRows(hi - lo, tasks) * m);
+    pairwiseBlockSumInto(lo, hi, m, zero, out, scratch.data(), accumulate, add, tasks);
+}
+
+#endif // ECE_PAIRWISESUM_H
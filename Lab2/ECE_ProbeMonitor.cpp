@@ -0,0 +1,134 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_ProbeMonitor class.
+Every update is exact up to rounding, but rounding accumulates over many
+updates; refresh() restores a fully recomputed baseline when needed. The
+corrections use the precision of the array's queries, so with -S they are
+computed in float like the baseline they are added to.
+
+*/
+
+#include "ECE_ProbeMonitor.h"
+#include <cmath>
+#include <omp.h>
+
+/**
+ * A charge before and after an update, q in Coulomb.
+ */
+struct ChargeChange {
+    double oldX, oldY, oldZ, oldQ;
+    double newX, newY, newZ, newQ;
+};
+
+/**
+ * Adds the field of a point charge at a probe, scaled by the Coulomb constant later.
+ * The difference, distance and scale are computed in Real, float for an array in
+ * single-precision mode like its kernel, and accumulated in double.
+ * A charge on top of the probe contributes nothing.
+ *
+ * @param p         The probe point.
+ * @param cx, cy, cz The location of the charge.
+ * @param cq        The charge in Coulomb, negated to remove a contribution.
+ * @param out       The field to accumulate into.
+ */
+template <typename Real>
+static inline void addContribution(const Point& p, double cx, double cy, double cz, double cq, Field& out) {
+    Real dx = Real(p.x) - Real(cx);
+    Real dy = Real(p.y) - Real(cy);
+    Real dz = Real(p.z) - Real(cz);
+    Real r_squared = dx * dx + dy * dy + dz * dz;
+    if (r_squared == Real(0)) {
+        return;
+    }
+    Real scale = Real(cq) / (std::sqrt(r_squared) * r_squared);
+    out.Ex += scale * dx;
+    out.Ey += scale * dy;
+    out.Ez += scale * dz;
+}
+
+/**
+ * Corrects the cached fields of every probe for a set of changed charges.
+ *
+ * @param probes    The probe points.
+ * @param fields    The cached fields to correct.
+ * @param changes   The old and new state of every changed charge.
+ */
+template <typename Real>
+static void correctFields(const std::vector<Point>& probes, std::vector<Field>& fields,
+                          const std::vector<ChargeChange>& changes) {
+    const long numProbes = long(probes.size());
+    const double k = ECE_ChargeArray::k;
+    #pragma omp parallel for if (numProbes * long(changes.size()) >= 4096)
+    for (long p = 0; p < numProbes; ++p) {
+        Field delta = {0.0, 0.0, 0.0};
+        for (const ChargeChange& change : changes) {
+            addContribution<Real>(probes[p], change.oldX, change.oldY, change.oldZ, -change.oldQ, delta);
+            addContribution<Real>(probes[p], change.newX, change.newY, change.newZ, change.newQ, delta);
+        }
+        fields[p].Ex += k * delta.Ex;
+        fields[p].Ey += k * delta.Ey;
+        fields[p].Ez += k * delta.Ez;
+    }
+}
+
+ECE_ProbeMonitor::ECE_ProbeMonitor(ECE_ChargeArray& charges) : charges(charges), numUpdates(0) {}
+
+std::size_t ECE_ProbeMonitor::addProbes(const Point* pts, std::size_t m) {
+    std::size_t first = probes.size();
+    probes.insert(probes.end(), pts, pts + m);
+    fields.resize(probes.size());
+    charges.evaluateField(pts, m, &fields[first]);
+    return first;
+}
+
+void ECE_ProbeMonitor::refresh() {
+    charges.evaluateField(probes.data(), probes.size(), fields.data());
+    numUpdates = 0;
+}
+
+void ECE_ProbeMonitor::applyUpdates(const ChargeUpdate* updates, std::size_t count) {
+    // Record both states of every changed charge, then write the new state into the array
+    std::vector<ChargeChange> changes(count);
+    for (std::size_t u = 0; u < count; ++u) {
+        const ChargeUpdate& update = updates[u];
+        ChargeChange& change = changes[u];
+        change.oldX = charges.getX(update.index);
+        change.oldY = charges.getY(update.index);
+        change.oldZ = charges.getZ(update.index);
+        change.oldQ = charges.getQ(update.index);
+        charges.setCharge(update.index, update.x, update.y, update.z, update.q);
+        change.newX = charges.getX(update.index);
+        change.newY = charges.getY(update.index);
+        change.newZ = charges.getZ(update.index);
+        change.newQ = charges.getQ(update.index);
+    }
+
+    // In the precision of the baseline from evaluateField, so an update matches a full recomputation
+    if (charges.isSinglePrecision()) {
+        correctFields<float>(probes, fields, changes);
+    } else {
+        correctFields<double>(probes, fields, changes);
+    }
+    numUpdates += count;
+}
+
+void ECE_ProbeMonitor::moveCharge(std::size_t i, double x, double y, double z) {
+    ChargeUpdate update = {i, x, y, z, charges.getQ(i) * 1.0e6};
+    applyUpdates(&update, 1);
+}
+
+void ECE_ProbeMonitor::setCharge(std::size_t i, double x, double y, double z, double q) {
+    ChargeUpdate update = {i, x, y, z, q};
+    applyUpdates(&update, 1);
+}
+
+void ECE_ProbeMonitor::getElectricField(std::size_t probe, double &Ex, double &Ey, double &Ez) const {
+    Ex = fields[probe].Ex;
+    Ey = fields[probe].Ey;
+    Ez = fields[probe].Ez;
+}
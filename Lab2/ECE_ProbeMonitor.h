@@ -0,0 +1,107 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_ProbeMonitor class.
+This class caches the total electric field at a set of registered probe
+points. When a few charges move or change their value, the cached fields
+are corrected by removing the old contribution of each changed charge and
+adding the new one, which costs O(changed x probes) instead of a full
+O(charges x probes) recomputation.
+
+*/
+
+#ifndef ECE_PROBEMONITOR_H
+#define ECE_PROBEMONITOR_H
+
+#include "ECE_ChargeArray.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief A new location and charge for one entry of the charge array.
+ */
+struct ChargeUpdate {
+    std::size_t index;  // index of the charge in the array
+    double x;
+    double y;
+    double z;
+    double q;           // new charge in micro Coulomb
+};
+
+class ECE_ProbeMonitor {
+protected:
+    ECE_ChargeArray& charges;   // the monitored charges, edited through this class
+    std::vector<Point> probes;  // registered probe points
+    std::vector<Field> fields;  // cached total field at every probe in V/m
+    std::size_t numUpdates;     // charge updates applied since the last full evaluation
+
+public:
+    /**
+     * @brief Constructor for ECE_ProbeMonitor class.
+     *
+     * @param charges The charge array to monitor. Changes made to it directly,
+     * rather than through this class, require a call to refresh().
+     */
+    explicit ECE_ProbeMonitor(ECE_ChargeArray& charges);
+    /**
+     * @brief Register probe points and compute their field with the batched query.
+     *
+     * @param pts The new probe points.
+     * @param m The number of new probe points.
+     * @return The index of the first new probe.
+     */
+    std::size_t addProbes(const Point* pts, std::size_t m);
+    /**
+     * @brief Recompute the field at every probe from all charges, discarding accumulated rounding.
+     */
+    void refresh();
+    /**
+     * @brief Change several charges and correct the cached fields.
+     *
+     * @param updates The new locations and charges.
+     * @param count The number of updates.
+     */
+    void applyUpdates(const ChargeUpdate* updates, std::size_t count);
+    /**
+     * @brief Move one charge, keeping its value.
+     *
+     * @param i The index of the charge.
+     * @param x The new x-coordinate.
+     * @param y The new y-coordinate.
+     * @param z The new z-coordinate.
+     */
+    void moveCharge(std::size_t i, double x, double y, double z);
+    /**
+     * @brief Change the location and value of one charge.
+     *
+     * @param i The index of the charge.
+     * @param x The new x-coordinate.
+     * @param y The new y-coordinate.
+     * @param z The new z-coordinate.
+     * @param q The new charge in micro Coulomb.
+     */
+    void setCharge(std::size_t i, double x, double y, double z, double q);
+    /**
+     * @brief Get the cached electric field at a probe.
+     *
+     * @param probe The index of the probe.
+     * @param Ex Reference to store the electric field in the x-direction.
+     * @param Ey Reference to store the electric field in the y-direction.
+     * @param Ez Reference to store the electric field in the z-direction.
+     */
+    void getElectricField(std::size_t probe, double &Ex, double &Ey, double &Ez) const;
+    /**
+     * @brief Get the number of registered probes.
+     */
+    std::size_t getNumProbes() const { return probes.size(); }
+    /**
+     * @brief Get the number of charge updates applied since the last full evaluation.
+     */
+    std::size_t getNumUpdates() const { return numUpdates; }
+};
+
+#endif // ECE_PROBEMONITOR_H
@@ -0,0 +1,183 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_QueryProfiler class.
+The three counters of a thread form one perf event group, so they are
+started, stopped and read together with a single read call, which also
+returns the times the group was enabled and running.
+
+*/
+
+#include "ECE_QueryProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+ECE_QueryProfiler::ECE_QueryProfiler(int numThreads)
+    : samples(new ThreadSample[numThreads > 0 ? numThreads : 1]), numThreads(numThreads > 0 ? numThreads : 1) {}
+
+ECE_QueryProfiler::~ECE_QueryProfiler() {
+#if defined(__linux__)
+    for (int id = 0; id < numThreads; ++id) {
+        for (int fd : {samples[id].counterFd, samples[id].memberFds[0], samples[id].memberFds[1]}) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+#endif
+}
+
+double ECE_QueryProfiler::now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ECE_QueryProfiler::openCounters(ThreadSample& sample) {
+    sample.counterFd = -1;
+#if defined(__linux__)
+    const std::uint64_t configs[3] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+    int fds[3] = {-1, -1, -1};
+    for (int c = 0; c < 3; ++c) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[c];
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = c == 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // pid 0 and cpu -1: the calling thread on any CPU
+        fds[c] = int(syscall(SYS_perf_event_open, &attr, 0, -1, c == 0 ? -1 : fds[0], 0));
+        if (fds[c] < 0) {
+            for (int o = 0; o < c; ++o) {
+                close(fds[o]);
+            }
+            return;
+        }
+    }
+    ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    sample.counterFd = fds[0];
+    sample.memberFds[0] = fds[1];
+    sample.memberFds[1] = fds[2];
+#endif
+}
+
+bool ECE_QueryProfiler::readCounters(const ThreadSample& sample, std::uint64_t counts[5]) {
+#if defined(__linux__)
+    if (sample.counterFd < 0) {
+        return false;
+    }
+    // nr, time enabled, time running, then the three counts
+    std::uint64_t values[6];
+    if (read(sample.counterFd, values, sizeof(values)) != ssize_t(sizeof(values)) || values[0] != 3) {
+        return false;
+    }
+    std::copy(values + 1, values + 6, counts);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ECE_QueryProfiler::reset() {
+    for (int id = 0; id < numThreads; ++id) {
+        ThreadSample& sample = samples[id];
+        sample.computeSeconds = sample.waitSeconds = 0.0;
+        sample.charges = 0;
+        sample.cycles = sample.instructions = sample.cacheMisses = 0;
+        sample.counted = true;
+    }
+}
+
+void ECE_QueryProfiler::beginCompute(int id) {
+    ThreadSample& sample = samples[id];
+    if (sample.counterFd == -2) {
+        openCounters(sample);
+    }
+    readCounters(sample, sample.startCounts);
+    sample.startTime = now();
+}
+
+void ECE_QueryProfiler::endCompute(int id, unsigned long charges) {
+    ThreadSample& sample = samples[id];
+    sample.computeSeconds += now() - sample.startTime;
+    sample.charges += charges;
+    std::uint64_t counts[5];
+    if (readCounters(sample, counts)) {
+        // Scale by enabled over running time, in case the group shared the PMU with other events
+        const std::uint64_t enabled = counts[0] - sample.startCounts[0];
+        const std::uint64_t running = counts[1] - sample.startCounts[1];
+        if (running == 0) {
+            if (enabled > 0) {
+                sample.counted = false;
+            }
+            return;
+        }
+        const double scale = double(enabled) / double(running);
+        sample.cycles += std::uint64_t(double(counts[2] - sample.startCounts[2]) * scale + 0.5);
+        sample.instructions += std::uint64_t(double(counts[3] - sample.startCounts[3]) * scale + 0.5);
+        sample.cacheMisses += std::uint64_t(double(counts[4] - sample.startCounts[4]) * scale + 0.5);
+    }
+}
+
+void ECE_QueryProfiler::addWait(int id, double seconds) {
+    samples[id].waitSeconds += seconds;
+}
+
+void ECE_QueryProfiler::report(std::ostream& out) const {
+    const bool counters = samples[0].counterFd >= 0;
+    double maxCompute = 0.0, sumCompute = 0.0, sumWait = 0.0;
+    int slowest = 0;
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << "Thread  compute(us)  wait(us)    charges";
+    if (counters) {
+        out << "       cycles    IPC  cache misses";
+    }
+    out << "\n" << std::fixed;
+    for (int id = 0; id < numThreads; ++id) {
+        const ThreadSample& sample = samples[id];
+        out << std::setw(6) << id << std::setprecision(1) << std::setw(13) << sample.computeSeconds * 1e6
+            << std::setw(10) << sample.waitSeconds * 1e6 << std::setw(11) << sample.charges;
+        if (counters && !sample.counted) {
+            out << "  not counted (the counters were multiplexed out)";
+        } else if (counters) {
+            double ipc = sample.cycles > 0 ? double(sample.instructions) / sample.cycles : 0.0;
+            out << std::setw(13) << sample.cycles << std::setprecision(2) << std::setw(7) << ipc
+                << std::setw(14) << sample.cacheMisses;
+        }
+        out << "\n";
+        if (sample.computeSeconds > maxCompute) {
+            maxCompute = sample.computeSeconds;
+            slowest = id;
+        }
+        sumCompute += sample.computeSeconds;
+        sumWait += sample.waitSeconds;
+    }
+
+    const double meanCompute = sumCompute / numThreads;
+    out << std::setprecision(1) << "Imbalance: slowest thread " << slowest << " computed for " << maxCompute * 1e6
+        << " us against a mean of " << meanCompute * 1e6 << " us ("
+        << (meanCompute > 0.0 ? (maxCompute / meanCompute - 1.0) * 100.0 : 0.0) << "% over); "
+        << (sumCompute + sumWait > 0.0 ? sumWait / (sumCompute + sumWait) * 100.0 : 0.0)
+        << "% of the thread time was spent waiting\n";
+    if (!counters) {
+        out << "Hardware counters are unavailable (perf_event_open was refused)\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
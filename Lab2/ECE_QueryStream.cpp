@@ -0,0 +1,206 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_QueryStream class.
+The input is read in large chunks and parsed with strtod in place; only
+the unfinished last line of a chunk is carried over to the next read.
+
+*/
+
+#include "ECE_QueryStream.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+const std::size_t ECE_QueryStream::READ_SIZE;
+
+/**
+ * Skips the separators between two coordinates.
+ *
+ * @param p         The current position in the line.
+ * @return          The first position that is not a space, tab or comma.
+ */
+static char* skipSeparators(char* p) {
+    while (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r') {
+        ++p;
+    }
+    return p;
+}
+
+/**
+ * Parses one line of the query file.
+ *
+ * @param line      The NUL-terminated line.
+ * @param point     Reference to store the parsed point.
+ * @return          1 if a point was parsed, 0 for a blank or comment line, -1 if malformed.
+ */
+static int parseLine(char* line, Point& point) {
+    char* p = skipSeparators(line);
+    if (*p == '\0' || *p == '#') {
+        return 0;
+    }
+    double values[3];
+    for (double& value : values) {
+        char* end;
+        value = std::strtod(p, &end);
+        if (end == p) {
+            return -1;
+        }
+        p = skipSeparators(end);
+    }
+    if (*p != '\0') {
+        return -1;
+    }
+    point = Point{values[0], values[1], values[2]};
+    return 1;
+}
+
+ECE_QueryStream::ECE_QueryStream(const std::string& filename, std::size_t blockSize, std::size_t maxQueued)
+    : file(nullptr), ownsFile(false), blockSize(blockSize > 0 ? blockSize : 1),
+      maxQueued(maxQueued > 0 ? maxQueued : 1), finished(false), stopping(false), skippedLines(0) {
+    if (filename == "-") {
+        file = stdin;
+    } else {
+        file = std::fopen(filename.c_str(), "r");
+        ownsFile = true;
+        if (file == nullptr) {
+            std::cerr << "Error: Unable to open file for reading: " << filename << std::endl;
+            return;
+        }
+    }
+    reader = std::thread(&ECE_QueryStream::readerLoop, this);
+}
+
+ECE_QueryStream::~ECE_QueryStream() {
+    close();
+    if (ownsFile && file != nullptr) {
+        std::fclose(file);
+    }
+}
+
+void ECE_QueryStream::close() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    notFull.notify_all();
+    if (reader.joinable()) {
+        reader.join();
+    }
+}
+
+bool ECE_QueryStream::push(std::vector<Point>& block) {
+    std::unique_lock<std::mutex> lock(mtx);
+    notFull.wait(lock, [&] { return queue.size() < maxQueued || stopping; });
+    if (stopping) {
+        return false;
+    }
+    queue.push_back(std::move(block));
+    notEmpty.notify_one();
+    block = std::vector<Point>();
+    block.reserve(blockSize);
+    return true;
+}
+
+void ECE_QueryStream::readerLoop() {
+    std::vector<char> buffer(READ_SIZE + 1);
+    std::vector<Point> block;
+    block.reserve(blockSize);
+    std::size_t carry = 0, skipped = 0;
+    bool eof = false, running = true;
+    bool discarding = false;    // inside a line longer than the buffer, skipped up to its '\n'
+
+    while (!eof && running) {
+        std::size_t got = std::fread(buffer.data() + carry, 1, READ_SIZE - carry, file);
+        std::size_t len = carry + got;
+        eof = got < READ_SIZE - carry;
+
+        if (discarding) {
+            char* newline = static_cast<char*>(std::memchr(buffer.data(), '\n', len));
+            if (newline == nullptr) {
+                carry = 0;
+                continue;
+            }
+            // Keep what follows the line and top the buffer up again before parsing
+            discarding = false;
+            carry = buffer.data() + len - (newline + 1);
+            std::memmove(buffer.data(), newline + 1, carry);
+            if (!eof) {
+                continue;
+            }
+            len = carry;
+        }
+
+        // Only whole lines are parsed; the tail waits for the next read unless the input ended
+        std::size_t end = len;
+        if (!eof) {
+            char* last = static_cast<char*>(memrchr(buffer.data(), '\n', len));
+            if (last == nullptr) {
+                // A single line longer than the buffer cannot be a point; drop it up to its end
+                ++skipped;
+                carry = 0;
+                discarding = true;
+                continue;
+            }
+            end = last - buffer.data() + 1;
+        }
+        char saved = buffer[end];
+        buffer[end] = '\0';
+
+        char* p = buffer.data();
+        char* stop = buffer.data() + end;
+        while (p < stop && running) {
+            char* newline = static_cast<char*>(std::memchr(p, '\n', stop - p));
+            char* lineEnd = newline != nullptr ? newline : stop;
+            *lineEnd = '\0';
+            Point point;
+            int status = parseLine(p, point);
+            if (status > 0) {
+                block.push_back(point);
+                if (block.size() == blockSize) {
+                    running = push(block);
+                }
+            } else if (status < 0) {
+                ++skipped;
+            }
+            p = lineEnd + 1;
+        }
+
+        buffer[end] = saved;
+        carry = len - end;
+        std::memmove(buffer.data(), buffer.data() + end, carry);
+
+        // Notice a consumer that gave up between two blocks, rather than reading the rest of the input
+        std::lock_guard<std::mutex> lock(mtx);
+        running = running && !stopping;
+    }
+
+    if (running && !block.empty()) {
+        push(block);
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    skippedLines = skipped;
+    finished = true;
+    notEmpty.notify_all();
+}
+
+bool ECE_QueryStream::next(std::vector<Point>& block) {
+    std::unique_lock<std::mutex> lock(mtx);
+    notEmpty.wait(lock, [&] { return !queue.empty() || finished; });
+    if (queue.empty()) {
+        return false;
+    }
+    block = std::move(queue.front());
+    queue.pop_front();
+    notFull.notify_one();
+    return true;
+}
+
+std::size_t ECE_QueryStream::getSkippedLines() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return skippedLines;
+}
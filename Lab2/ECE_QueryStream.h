@@ -0,0 +1,88 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_QueryStream class.
+This class streams query points from a text file or a pipe. A reader
+thread parses the input into blocks of points and hands them over through
+a bounded queue, so parsing the next block overlaps with evaluating the
+current one and memory stays bounded for inputs of any length.
+
+Each line holds "x y z" in meters, separated by spaces, tabs or commas.
+Empty lines and lines starting with '#' are ignored.
+
+*/
+
+#ifndef ECE_QUERYSTREAM_H
+#define ECE_QUERYSTREAM_H
+
+#include "ECE_ChargeArray.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ECE_QueryStream {
+protected:
+    static const std::size_t READ_SIZE = 1 << 20; // bytes read from the input at a time
+
+    FILE* file;                 // the input, stdin for "-"
+    bool ownsFile;              // false for stdin
+    std::size_t blockSize;      // points per block
+    std::size_t maxQueued;      // parsed blocks waiting for the consumer
+
+    std::mutex mtx;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::deque<std::vector<Point>> queue;
+    bool finished;              // the reader has reached the end of the input
+    bool stopping;              // the consumer is gone, the reader should quit
+    std::size_t skippedLines;   // malformed lines that were ignored
+    std::thread reader;
+
+    void readerLoop();
+    bool push(std::vector<Point>& block);
+
+public:
+    /**
+     * @brief Constructor for ECE_QueryStream class. Opens the input and starts the reader thread.
+     *
+     * @param filename The query file, or "-" for the standard input.
+     * @param blockSize The number of points per block.
+     * @param maxQueued The number of parsed blocks buffered ahead of the consumer.
+     */
+    ECE_QueryStream(const std::string& filename, std::size_t blockSize = 65536, std::size_t maxQueued = 4);
+    /**
+     * @brief Stops and joins the reader thread and closes the input.
+     */
+    ~ECE_QueryStream();
+    /**
+     * @brief Stop the reader thread and join it, e.g. when the consumer gives up before the end of the input.
+     * A reader waiting on a full queue is woken; next() returns the blocks already queued, then false.
+     */
+    void close();
+    /**
+     * @brief Check if the input was opened.
+     */
+    bool isOpen() const { return file != nullptr; }
+    /**
+     * @brief Wait for the next block of points.
+     *
+     * @param block Reference to store the points; its previous contents are discarded.
+     * @return True if a block was returned, false at the end of the input.
+     */
+    bool next(std::vector<Point>& block);
+    /**
+     * @brief Get the number of malformed lines that were ignored, once next() has returned false.
+     */
+    std::size_t getSkippedLines();
+};
+
+#endif // ECE_QUERYSTREAM_H
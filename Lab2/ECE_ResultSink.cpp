@@ -0,0 +1,246 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_ResultSink classes.
+
+*/
+
+#include "ECE_ResultSink.h"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+const std::size_t ECE_ResultSink::BUFFER_SIZE;
+
+// Columns of the field and of the symmetric gradient as a 3 x 3 tensor, for both record layouts
+static const int FIELD_COLUMNS[2][3] = {{3, 4, 5}, {4, 5, 6}};
+static const int POINT_COLUMNS[3] = {0, 1, 2};
+static const int POTENTIAL_COLUMNS[1] = {3};
+static const int GRADIENT_COLUMNS[9] = {7, 10, 11, 10, 8, 12, 11, 12, 9};
+
+void toBigEndian(double value, unsigned char* bytes) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+    }
+}
+
+void toBigEndian32(uint32_t bits, unsigned char* bytes) {
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<unsigned char>(bits >> (24 - 8 * i));
+    }
+}
+
+/**
+ * Checks the extension of a file name.
+ *
+ * @param filename  The file name.
+ * @param extension The extension, including the dot.
+ * @return          True if the name ends in the extension.
+ */
+static bool hasExtension(const std::string& filename, const char* extension) {
+    const std::size_t length = std::strlen(extension);
+    return filename.size() >= length && filename.compare(filename.size() - length, length, extension) == 0;
+}
+
+ECE_ResultSink::ECE_ResultSink(const std::string& filename, bool allTerms, bool binary)
+    : file(nullptr), ownsFile(false), allTerms(allTerms) {
+    if (filename == "-") {
+        // stdout may already have been used, so it keeps its own buffering
+        file = stdout;
+        return;
+    }
+    file = std::fopen(filename.c_str(), binary ? "wb" : "w");
+    ownsFile = true;
+    if (file == nullptr) {
+        std::cerr << "Error: Unable to open file for writing: " << filename << std::endl;
+        return;
+    }
+    buffer.resize(BUFFER_SIZE);
+    std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+}
+
+ECE_ResultSink::~ECE_ResultSink() {
+    if (ownsFile && file != nullptr) {
+        std::fclose(file);
+    }
+}
+
+std::unique_ptr<ECE_ResultSink> ECE_ResultSink::create(const std::string& filename, bool allTerms,
+                                                       const ProbeGrid* grid) {
+    if (hasExtension(filename, ".bin")) {
+        return std::unique_ptr<ECE_ResultSink>(new ECE_RecordSink(filename, allTerms));
+    } else if (hasExtension(filename, ".col")) {
+        return std::unique_ptr<ECE_ResultSink>(new ECE_ColumnSink(filename, allTerms));
+    } else if (hasExtension(filename, ".vtk")) {
+        return std::unique_ptr<ECE_ResultSink>(new ECE_VtkSink(filename, allTerms, grid));
+    }
+    return std::unique_ptr<ECE_ResultSink>(new ECE_CsvSink(filename, allTerms));
+}
+
+bool ECE_ResultSink::finish() {
+    return std::fflush(file) == 0 && !std::ferror(file);
+}
+
+ECE_CsvSink::ECE_CsvSink(const std::string& filename, bool allTerms)
+    : ECE_ResultSink(filename, allTerms, false) {
+    if (isOpen()) {
+        std::fputs(allTerms ? "x,y,z,V,Ex,Ey,Ez,Gxx,Gyy,Gzz,Gxy,Gxz,Gyz\n" : "x,y,z,Ex,Ey,Ez\n", file);
+    }
+}
+
+bool ECE_CsvSink::writeChunk(const double* records, std::size_t m) {
+    for (std::size_t i = 0; i < m; ++i) {
+        const double* r = records + i * getColumns();
+        if (allTerms) {
+            std::fprintf(file, "%.9g,%.9g,%.9g,%.9e,%.9e,%.9e,%.9e,%.9e,%.9e,%.9e,%.9e,%.9e,%.9e\n",
+                         r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[8], r[9], r[10], r[11], r[12]);
+        } else {
+            std::fprintf(file, "%.9g,%.9g,%.9g,%.9e,%.9e,%.9e\n", r[0], r[1], r[2], r[3], r[4], r[5]);
+        }
+    }
+    return !std::ferror(file);
+}
+
+ECE_RecordSink::ECE_RecordSink(const std::string& filename, bool allTerms)
+    : ECE_ResultSink(filename, allTerms, true) {}
+
+bool ECE_RecordSink::writeChunk(const double* records, std::size_t m) {
+    const std::size_t count = m * getColumns();
+    return std::fwrite(records, sizeof(double), count, file) == count;
+}
+
+ECE_ColumnSink::ECE_ColumnSink(const std::string& filename, bool allTerms)
+    : ECE_ResultSink(filename, allTerms, true) {
+    if (isOpen()) {
+        const char* names = allTerms ? "x,y,z,V,Ex,Ey,Ez,Gxx,Gyy,Gzz,Gxy,Gxz,Gyz\n" : "x,y,z,Ex,Ey,Ez\n";
+        const uint32_t numColumns = uint32_t(getColumns());
+        std::fwrite("EFCOLS1", 1, 7, file);
+        std::fwrite(&numColumns, sizeof(numColumns), 1, file);
+        std::fputs(names, file);
+    }
+}
+
+bool ECE_ColumnSink::writeChunk(const double* records, std::size_t m) {
+    const std::size_t numColumns = getColumns();
+    columns.resize(m * numColumns);
+    for (std::size_t i = 0; i < m; ++i) {
+        for (std::size_t c = 0; c < numColumns; ++c) {
+            columns[c * m + i] = records[i * numColumns + c];
+        }
+    }
+    const uint64_t count = m;
+    return std::fwrite(&count, sizeof(count), 1, file) == 1
+           && std::fwrite(columns.data(), sizeof(double), columns.size(), file) == columns.size();
+}
+
+ECE_VtkSink::ECE_VtkSink(const std::string& filename, bool allTerms, const ProbeGrid* grid)
+    : ECE_ResultSink(filename, allTerms, true), hasGrid(grid != nullptr), grid(), count(0),
+      staged{nullptr, nullptr, nullptr, nullptr} {
+    if (grid != nullptr) {
+        this->grid = *grid;
+    }
+    if (!isOpen()) {
+        return;
+    }
+    const bool used[4] = {!hasGrid, true, allTerms, allTerms};
+    for (int a = 0; a < 4; ++a) {
+        if (used[a] && (staged[a] = std::tmpfile()) == nullptr) {
+            std::cerr << "Error: Unable to create a temporary file for " << filename << std::endl;
+            std::fclose(file);
+            file = nullptr;
+            return;
+        }
+    }
+}
+
+ECE_VtkSink::~ECE_VtkSink() {
+    for (FILE* f : staged) {
+        if (f != nullptr) {
+            std::fclose(f);
+        }
+    }
+}
+
+bool ECE_VtkSink::stage(int array, const double* records, std::size_t m, const int* columns, int numColumns) {
+    bytes.resize(m * numColumns * 8);
+    for (std::size_t i = 0; i < m; ++i) {
+        for (int c = 0; c < numColumns; ++c) {
+            toBigEndian(records[i * getColumns() + columns[c]], &bytes[(i * numColumns + c) * 8]);
+        }
+    }
+    return std::fwrite(bytes.data(), 1, bytes.size(), staged[array]) == bytes.size();
+}
+
+bool ECE_VtkSink::writeChunk(const double* records, std::size_t m) {
+    bool ok = true;
+    if (!hasGrid) {
+        ok = stage(0, records, m, POINT_COLUMNS, 3);
+    }
+    ok = ok && stage(1, records, m, FIELD_COLUMNS[allTerms ? 1 : 0], 3);
+    if (allTerms) {
+        ok = ok && stage(2, records, m, POTENTIAL_COLUMNS, 1) && stage(3, records, m, GRADIENT_COLUMNS, 9);
+    }
+    count += m;
+    return ok;
+}
+
+bool ECE_VtkSink::append(int array) {
+    std::rewind(staged[array]);
+    bytes.resize(BUFFER_SIZE);
+    std::size_t got;
+    while ((got = std::fread(bytes.data(), 1, bytes.size(), staged[array])) > 0) {
+        if (std::fwrite(bytes.data(), 1, got, file) != got) {
+            return false;
+        }
+    }
+    std::fputc('\n', file);
+    return !std::ferror(staged[array]);
+}
+
+bool ECE_VtkSink::finish() {
+    if (hasGrid && count != grid.size()) {
+        std::cerr << "Error: " << count << " results for a probe grid of " << grid.size() << " points" << std::endl;
+        return false;
+    }
+    std::fprintf(file, "# vtk DataFile Version 3.0\nElectric field probes\nBINARY\n");
+    if (hasGrid) {
+        std::fprintf(file, "DATASET STRUCTURED_POINTS\nDIMENSIONS %d %d %d\nORIGIN %.17g %.17g %.17g\n"
+                     "SPACING %.17g %.17g %.17g\n", grid.nodes[0], grid.nodes[1], grid.nodes[2],
+                     grid.box[0], grid.box[2], grid.box[4], grid.spacing(0), grid.spacing(1), grid.spacing(2));
+    } else {
+        // Points, and one vertex cell per point so that viewers draw them
+        std::fprintf(file, "DATASET POLYDATA\nPOINTS %zu double\n", count);
+        if (!append(0)) {
+            return false;
+        }
+        std::fprintf(file, "VERTICES %zu %zu\n", count, 2 * count);
+        unsigned char cell[8];
+        toBigEndian32(1, cell);
+        for (std::size_t i = 0; i < count; ++i) {
+            toBigEndian32(uint32_t(i), cell + 4);
+            std::fwrite(cell, 1, sizeof(cell), file);
+        }
+        std::fputc('\n', file);
+    }
+    std::fprintf(file, "POINT_DATA %zu\nVECTORS E double\n", count);
+    if (!append(1)) {
+        return false;
+    }
+    if (allTerms) {
+        std::fprintf(file, "SCALARS V double 1\nLOOKUP_TABLE default\n");
+        if (!append(2)) {
+            return false;
+        }
+        std::fprintf(file, "TENSORS gradient double\n");
+        if (!append(3)) {
+            return false;
+        }
+    }
+    return ECE_ResultSink::finish();
+}
@@ -0,0 +1,167 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_ResultSink classes.
+A result sink encodes chunks of query results into one output format. A
+chunk holds m records of the same columns, x y z Ex Ey Ez, or with all
+terms x y z V Ex Ey Ez Gxx Gyy Gzz Gxy Gxz Gyz. ECE_ResultWriter runs the
+sinks on its I/O thread, so formatting never delays the queries. The
+format follows the file name:
+
+    ".bin"  packed native-double records, no header (ECE_RecordSink)
+    ".col"  binary columns, "EFCOLS1", uint32 column count and a line of
+            comma-separated names, then per chunk a uint64 point count and
+            each column as a run of native doubles (ECE_ColumnSink)
+    ".vtk"  legacy binary VTK, structured points for a probe grid and
+            vertices otherwise, with E, V and the gradient tensor as point
+            data (ECE_VtkSink)
+    other   CSV with a header line, also used for "-" (ECE_CsvSink)
+
+*/
+
+#ifndef ECE_RESULTSINK_H
+#define ECE_RESULTSINK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A regular grid of probe points, swept with x fastest, then y, then z.
+ */
+struct ProbeGrid {
+    double box[6];  // xMin xMax yMin yMax zMin zMax
+    int nodes[3];   // nodes along x, y and z, at least 1 each
+
+    std::size_t size() const { return std::size_t(nodes[0]) * nodes[1] * nodes[2]; }
+    double spacing(int axis) const {
+        return nodes[axis] > 1 ? (box[2 * axis + 1] - box[2 * axis]) / (nodes[axis] - 1) : 1.0;
+    }
+};
+
+/**
+ * @brief Convert a double into big-endian byte order, as legacy VTK binary files require.
+ *
+ * @param value The value to convert.
+ * @param bytes The 8 bytes receiving the value.
+ */
+void toBigEndian(double value, unsigned char* bytes);
+/**
+ * @brief Convert a 32-bit value into big-endian byte order.
+ *
+ * @param bits The bits of the value.
+ * @param bytes The 4 bytes receiving the value.
+ */
+void toBigEndian32(uint32_t bits, unsigned char* bytes);
+
+class ECE_ResultSink {
+protected:
+    FILE* file;                 // the output, stdout for "-"
+    bool ownsFile;              // false for stdout
+    bool allTerms;              // 13 columns instead of 6
+    std::vector<char> buffer;   // stdio buffer of an output file
+
+    /**
+     * @brief Opens the output; the derived constructors check isOpen() before writing headers.
+     */
+    ECE_ResultSink(const std::string& filename, bool allTerms, bool binary);
+
+public:
+    static const std::size_t BUFFER_SIZE = 1 << 20; // stdio buffer of the output
+
+    /**
+     * @brief Closes the output; call finish() first to complete the file.
+     */
+    virtual ~ECE_ResultSink();
+    /**
+     * @brief Create the sink matching the extension of a file name.
+     *
+     * @param filename The output file, or "-" for CSV on the standard output.
+     * @param allTerms True for the potential and field gradient columns as well.
+     * @param grid The swept probe grid, or nullptr when the points are streamed.
+     * @return The sink, which may have failed to open.
+     */
+    static std::unique_ptr<ECE_ResultSink> create(const std::string& filename, bool allTerms, const ProbeGrid* grid);
+    /**
+     * @brief Check if the output was opened.
+     */
+    bool isOpen() const { return file != nullptr; }
+    /**
+     * @brief Get the number of doubles per record.
+     */
+    std::size_t getColumns() const { return allTerms ? 13 : 6; }
+    /**
+     * @brief Encode a chunk of records.
+     *
+     * @param records The m records of getColumns() doubles each.
+     * @param m The number of records.
+     * @return True if the chunk was written, false on an output error.
+     */
+    virtual bool writeChunk(const double* records, std::size_t m) = 0;
+    /**
+     * @brief Complete the file after the last chunk and flush it.
+     *
+     * @return True if the whole file was written, false on an output error.
+     */
+    virtual bool finish();
+};
+
+/**
+ * @brief CSV text, one line per record.
+ */
+class ECE_CsvSink : public ECE_ResultSink {
+public:
+    ECE_CsvSink(const std::string& filename, bool allTerms);
+    bool writeChunk(const double* records, std::size_t m) override;
+};
+
+/**
+ * @brief Packed native-double records, the original binary output.
+ */
+class ECE_RecordSink : public ECE_ResultSink {
+public:
+    ECE_RecordSink(const std::string& filename, bool allTerms);
+    bool writeChunk(const double* records, std::size_t m) override;
+};
+
+/**
+ * @brief Native doubles grouped by column within every chunk.
+ */
+class ECE_ColumnSink : public ECE_ResultSink {
+protected:
+    std::vector<double> columns; // the chunk transposed
+public:
+    ECE_ColumnSink(const std::string& filename, bool allTerms);
+    bool writeChunk(const double* records, std::size_t m) override;
+};
+
+/**
+ * @brief Legacy binary VTK. The sections need the point count up front and
+ * one array after the other, so each array is staged in a temporary file
+ * and the VTK file is assembled by finish().
+ */
+class ECE_VtkSink : public ECE_ResultSink {
+protected:
+    bool hasGrid;                       // structured points instead of vertices
+    ProbeGrid grid;
+    std::size_t count;                  // records written so far
+    FILE* staged[4];                    // big-endian points, E, V and gradient
+    std::vector<unsigned char> bytes;   // one array of a chunk in big-endian order
+
+    bool stage(int array, const double* records, std::size_t m, const int* columns, int numColumns);
+    bool append(int array);
+public:
+    ECE_VtkSink(const std::string& filename, bool allTerms, const ProbeGrid* grid);
+    ~ECE_VtkSink() override;
+    bool writeChunk(const double* records, std::size_t m) override;
+    bool finish() override;
+};
+
+#endif // ECE_RESULTSINK_H
@@ -0,0 +1,134 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation file for the ECE_ResultWriter class.
+Only the I/O thread touches the sink; the caller only packs records into
+the chunk being filled, and swaps chunks once the I/O thread is idle.
+
+*/
+
+#include "ECE_ResultWriter.h"
+#include <chrono>
+
+const std::size_t ECE_ResultWriter::CHUNK_POINTS;
+
+ECE_ResultWriter::ECE_ResultWriter(const std::string& filename, bool allTerms, const ProbeGrid* grid)
+    : sink(ECE_ResultSink::create(filename, allTerms, grid)), columns(sink->getColumns()), filling(0), filled(0),
+      writing(0), stopping(false), failed(false), closed(false), waitSeconds(0.0) {
+    if (!sink->isOpen()) {
+        closed = true;
+        return;
+    }
+    chunks[0].resize(CHUNK_POINTS * columns);
+    chunks[1].resize(CHUNK_POINTS * columns);
+    writer = std::thread(&ECE_ResultWriter::writerLoop, this);
+}
+
+ECE_ResultWriter::~ECE_ResultWriter() {
+    close();
+}
+
+void ECE_ResultWriter::writerLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        handedOver.wait(lock, [&] { return writing > 0 || stopping; });
+        if (writing == 0) {
+            break;
+        }
+        // The chunk that is not filling stays untouched until writing drops back to 0
+        const double* records = chunks[1 - filling].data();
+        const std::size_t m = writing;
+        lock.unlock();
+        const bool ok = sink->writeChunk(records, m);
+        lock.lock();
+        failed = failed || !ok;
+        writing = 0;
+        written.notify_all();
+    }
+}
+
+bool ECE_ResultWriter::handOver() {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (writing > 0) {
+        auto wait_start = std::chrono::steady_clock::now();
+        written.wait(lock, [&] { return writing == 0; });
+        waitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - wait_start).count();
+    }
+    writing = filled;
+    filling = 1 - filling;
+    filled = 0;
+    handedOver.notify_one();
+    return !failed;
+}
+
+double* ECE_ResultWriter::nextRecord() {
+    if (filled == CHUNK_POINTS) {
+        handOver();
+    }
+    return &chunks[filling][columns * filled++];
+}
+
+bool ECE_ResultWriter::write(const Point* pts, const Field* out, std::size_t m) {
+    if (closed) {
+        return false;
+    }
+    for (std::size_t i = 0; i < m; ++i) {
+        double* r = nextRecord();
+        r[0] = pts[i].x;
+        r[1] = pts[i].y;
+        r[2] = pts[i].z;
+        r[3] = out[i].Ex;
+        r[4] = out[i].Ey;
+        r[5] = out[i].Ez;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    return !failed;
+}
+
+bool ECE_ResultWriter::write(const Point* pts, const FieldTerms* out, std::size_t m) {
+    if (closed) {
+        return false;
+    }
+    for (std::size_t i = 0; i < m; ++i) {
+        const FieldTerms& t = out[i];
+        double* r = nextRecord();
+        r[0] = pts[i].x;
+        r[1] = pts[i].y;
+        r[2] = pts[i].z;
+        r[3] = t.V;
+        r[4] = t.Ex;
+        r[5] = t.Ey;
+        r[6] = t.Ez;
+        r[7] = t.Gxx;
+        r[8] = t.Gyy;
+        r[9] = t.Gzz;
+        r[10] = t.Gxy;
+        r[11] = t.Gxz;
+        r[12] = t.Gyz;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    return !failed;
+}
+
+bool ECE_ResultWriter::close() {
+    if (closed) {
+        return !failed && isOpen();
+    }
+    closed = true;
+    if (filled > 0) {
+        handOver();
+    }
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        written.wait(lock, [&] { return writing == 0; });
+        stopping = true;
+    }
+    handedOver.notify_one();
+    writer.join();
+    failed = !sink->finish() || failed;
+    return !failed;
+}
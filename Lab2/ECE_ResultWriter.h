@@ -0,0 +1,103 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header file for the ECE_ResultWriter class.
+This class writes the query points and their fields to a file or to the
+standard output through the ECE_ResultSink chosen by the file name (CSV,
+".bin" records, ".col" columns or ".vtk"). The results are copied into one
+of two chunks; a full chunk is handed to an I/O thread that formats and
+writes it while the other chunk fills, so the queries only wait when the
+output falls a whole chunk behind. Without all terms the records hold
+x y z Ex Ey Ez, with all terms x y z V Ex Ey Ez Gxx Gyy Gzz Gxy Gxz Gyz.
+
+*/
+
+#ifndef ECE_RESULTWRITER_H
+#define ECE_RESULTWRITER_H
+
+#include "ECE_ChargeArray.h"
+#include "ECE_FieldTerms.h"
+#include "ECE_ResultSink.h"
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ECE_ResultWriter {
+protected:
+    static const std::size_t CHUNK_POINTS = 1 << 16; // records per chunk handed to the I/O thread
+
+    std::unique_ptr<ECE_ResultSink> sink;
+    std::size_t columns;            // doubles per record
+    std::vector<double> chunks[2];  // the chunk being filled and the chunk being written
+    int filling;                    // index of the chunk being filled
+    std::size_t filled;             // records in the chunk being filled
+    std::size_t writing;            // records handed to the I/O thread, 0 when it is idle
+    bool stopping;                  // no more chunks, the I/O thread should quit
+    bool failed;                    // the sink reported an output error
+    bool closed;
+    double waitSeconds;             // time write() spent waiting for the I/O thread
+    std::mutex mtx;
+    std::condition_variable handedOver; // a chunk was handed over, or stopping was set
+    std::condition_variable written;    // the I/O thread finished its chunk
+    std::thread writer;
+
+    void writerLoop();
+    bool handOver();
+    double* nextRecord();
+
+public:
+    /**
+     * @brief Constructor for ECE_ResultWriter class. Opens the output and starts the I/O thread.
+     *
+     * @param filename The output file, or "-" for the standard output.
+     * @param allTerms True to write the potential and field gradient as well as the field.
+     * @param grid The swept probe grid, for the VTK structured-points output; nullptr for streamed points.
+     */
+    explicit ECE_ResultWriter(const std::string& filename, bool allTerms = false, const ProbeGrid* grid = nullptr);
+    /**
+     * @brief Writes the remaining results, joins the I/O thread and closes the output.
+     */
+    ~ECE_ResultWriter();
+    /**
+     * @brief Check if the output was opened.
+     */
+    bool isOpen() const { return sink && sink->isOpen(); }
+    /**
+     * @brief Append a block of results.
+     *
+     * @param pts The query points.
+     * @param out The fields at the query points.
+     * @param m The number of points.
+     * @return False once the output has failed, true otherwise.
+     */
+    bool write(const Point* pts, const Field* out, std::size_t m);
+    /**
+     * @brief Append a block of results with all terms.
+     *
+     * @param pts The query points.
+     * @param out The potential, field and field gradient at the query points.
+     * @param m The number of points.
+     * @return False once the output has failed, true otherwise.
+     */
+    bool write(const Point* pts, const FieldTerms* out, std::size_t m);
+    /**
+     * @brief Write the remaining results, complete the file and stop the I/O thread.
+     *
+     * @return True if all results were written, false on an output error.
+     */
+    bool close();
+    /**
+     * @brief Get the time the callers of write() waited for the I/O thread, in seconds.
+     */
+    double getWaitSeconds() const { return waitSeconds; }
+};
+
+#endif // ECE_RESULTWRITER_H
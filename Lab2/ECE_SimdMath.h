@@ -0,0 +1,105 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Header-only SIMD helpers shared by the field kernels of ECE_ChargeArray.cpp,
+ECE_LatticeKernel.h and ECE_FieldTerms.h: the reciprocal square root of a
+register, refined from the hardware estimate by Newton-Raphson steps, and
+the horizontal sums of the accumulators. Only the helpers of the instruction
+set selected at compile time are defined.
+
+*/
+
+#ifndef ECE_SIMDMATH_H
+#define ECE_SIMDMATH_H
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX512F__)
+/**
+ * Computes 1/sqrt(v) to full double precision: the 14-bit hardware estimate is
+ * refined with two Newton-Raphson steps, which is much cheaper than sqrt + div.
+ *
+ * @param v     The register of positive values.
+ * @return      The reciprocal square root of every lane.
+ */
+inline __m512d reciprocalSqrt(__m512d v) {
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d threeHalves = _mm512_set1_pd(1.5);
+    __m512d halfV = _mm512_mul_pd(half, v);
+    __m512d r = _mm512_rsqrt14_pd(v);
+    r = _mm512_mul_pd(r, _mm512_fnmadd_pd(halfV, _mm512_mul_pd(r, r), threeHalves));
+    r = _mm512_mul_pd(r, _mm512_fnmadd_pd(halfV, _mm512_mul_pd(r, r), threeHalves));
+    return r;
+}
+
+/**
+ * Computes 1/sqrt(v) to single precision: one Newton-Raphson step on the 14-bit estimate.
+ *
+ * @param v     The register of positive values.
+ * @return      The reciprocal square root of every lane.
+ */
+inline __m512 reciprocalSqrt(__m512 v) {
+    const __m512 halfV = _mm512_mul_ps(_mm512_set1_ps(0.5f), v);
+    __m512 r = _mm512_rsqrt14_ps(v);
+    return _mm512_mul_ps(r, _mm512_fnmadd_ps(halfV, _mm512_mul_ps(r, r), _mm512_set1_ps(1.5f)));
+}
+
+/**
+ * Adds the sixteen lanes of a float register together in double.
+ *
+ * @param v     The register to reduce.
+ * @return      The sum of all lanes.
+ */
+inline double horizontalSumToDouble(__m512 v) {
+    __m256 lo = _mm512_castps512_ps256(v);
+    __m256 hi = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+    return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_cvtps_pd(lo), _mm512_cvtps_pd(hi)));
+}
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__) && !defined(__AVX512F__)
+/**
+ * Computes 1/sqrt(v) to single precision: one Newton-Raphson step on the 12-bit estimate.
+ *
+ * @param v     The register of positive values.
+ * @return      The reciprocal square root of every lane.
+ */
+inline __m256 reciprocalSqrt(__m256 v) {
+    const __m256 halfV = _mm256_mul_ps(_mm256_set1_ps(0.5f), v);
+    __m256 r = _mm256_rsqrt_ps(v);
+    return _mm256_mul_ps(r, _mm256_fnmadd_ps(halfV, _mm256_mul_ps(r, r), _mm256_set1_ps(1.5f)));
+}
+
+/**
+ * Adds the four lanes of an AVX register together.
+ *
+ * @param v     The register to reduce.
+ * @return      The sum of all lanes.
+ */
+inline double horizontalSum(__m256d v) {
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+/**
+ * Adds the eight lanes of a float register together in double.
+ *
+ * @param v     The register to reduce.
+ * @return      The sum of all lanes.
+ */
+inline double horizontalSumToDouble(__m256 v) {
+    __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+    __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+    return horizontalSum(_mm256_add_pd(lo, hi));
+}
+#endif
+
+#endif // ECE_SIMDMATH_H
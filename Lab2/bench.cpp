@@ -0,0 +1,453 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Scaling benchmark for the electric-field backends. It sweeps lattice size,
+thread count and backend, repeats every query, and reports the median and
+p99 latency, charges per second and parallel efficiency as CSV or JSON.
+
+Backends:
+    object  - the original per-object ECE_ElectricField loop (1 thread only)
+    thread  - the Lab1 std::thread pool over the SIMD kernel
+    openmp  - the Lab2 OpenMP loop over the SIMD kernel
+    batch   - batched, cache-tiled evaluateField (latency per point)
+    single  - batch with the single-precision kernel (latency per point)
+    lattice - batch with the lattice kernel, which generates the positions
+              from the indices and reads no charge memory (latency per point)
+    tree    - Barnes-Hut octree, batched over points (latency per point)
+    update  - ECE_ProbeMonitor correcting the fields at the batch points after 8
+              changed charges (latency per update step)
+    stream  - every thread reads its slice of 32 bytes per charge, written by
+              the same thread with the same split (first touch); besides the
+              total it reports a "stream/node<N>" row for the threads reading
+              node N's memory from node N and a "stream/node<N>/remote" row for
+              those reading it from other nodes, whose charges_per_sec times 32
+              bytes is the read bandwidth
+
+The charges are written by the threads that read them in the kernels, so
+they are placed on the NUMA nodes of those threads by first touch. With
+-A the OpenMP threads and the thread pool are pinned
+(none, compact, scatter or a CPU list such as 0,2,4-7).
+
+Usage: bench [-L <sizes>] [-P <threads>] [-R <repeats>] [-B <backends>]
+             [-A <affinity>] [-F <csv|json>] [-O <output file>]
+    lists are comma separated, e.g. -L 100,300,1000 -P 1,2,4,8; thread counts
+    run in ascending order, and the efficiency is left empty (null in JSON)
+    when 1 is not among them
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include "ECE_Affinity.h"
+#include "ECE_Autotuner.h"
+#include "ECE_ChargeArray.h"
+#include "ECE_ChargeTree.h"
+#include "ECE_ElectricField.h"
+#include "ECE_ProbeMonitor.h"
+#include "ECE_ThreadPool.h"
+
+using namespace std;
+
+const int BATCH_POINTS = 256; // query points per batch for the batched backends
+double streamSink = 0.0;      // keeps the sums of the stream backend alive
+
+/**
+ * Partial field of one pool thread, on its own cache line like Lab1's, so the
+ * threads of the "thread" backend do not share lines while they store their results.
+ */
+struct alignas(64) PartialField {
+    double Ex = 0.0;
+    double Ey = 0.0;
+    double Ez = 0.0;
+};
+
+/**
+ * One row of the benchmark report.
+ */
+struct BenchResult {
+    string backend;
+    int rows;
+    int cols;
+    int threads;
+    int repeats;
+    double medianMicroseconds;
+    double p99Microseconds;
+    double chargesPerSecond;
+    double efficiency;          // NaN when there is no 1-thread baseline
+};
+
+/**
+ * Splits a comma separated list of integers.
+ *
+ * @param text      The list, e.g. "1,2,4".
+ * @return          The parsed values.
+ */
+vector<int> parseIntList(const string& text) {
+    vector<int> values;
+    stringstream stream(text);
+    string item;
+    while (getline(stream, item, ',')) {
+        values.push_back(atoi(item.c_str()));
+    }
+    return values;
+}
+
+/**
+ * Splits a comma separated list of names.
+ *
+ * @param text      The list, e.g. "openmp,tree".
+ * @return          The names.
+ */
+vector<string> parseNameList(const string& text) {
+    vector<string> values;
+    stringstream stream(text);
+    string item;
+    while (getline(stream, item, ',')) {
+        values.push_back(item);
+    }
+    return values;
+}
+
+/**
+ * Times a query several times after one warm-up run.
+ *
+ * @param query     The query to run.
+ * @param repeats   The number of timed runs.
+ * @return          The run times in microseconds, sorted.
+ */
+vector<double> timeQuery(const function<void()>& query, int repeats) {
+    vector<double> times(repeats);
+    query();
+    for (int r = 0; r < repeats; ++r) {
+        double start_time = omp_get_wtime();
+        query();
+        times[r] = (omp_get_wtime() - start_time) * 1e6;
+    }
+    sort(times.begin(), times.end());
+    return times;
+}
+
+/**
+ * Writes the results as CSV.
+ *
+ * @param out       The output stream.
+ * @param results   The benchmark results.
+ */
+void writeCSV(ostream& out, const vector<BenchResult>& results) {
+    out << "backend,rows,cols,charges,threads,repeats,median_us,p99_us,charges_per_sec,efficiency\n";
+    for (const BenchResult& r : results) {
+        out << r.backend << "," << r.rows << "," << r.cols << "," << (long)r.rows * r.cols << ","
+            << r.threads << "," << r.repeats << "," << r.medianMicroseconds << "," << r.p99Microseconds << ","
+            << r.chargesPerSecond << ",";
+        if (!std::isnan(r.efficiency)) {
+            out << r.efficiency;
+        }
+        out << "\n";
+    }
+}
+
+/**
+ * Writes the results as a JSON array.
+ *
+ * @param out       The output stream.
+ * @param results   The benchmark results.
+ */
+void writeJSON(ostream& out, const vector<BenchResult>& results) {
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "  {\"backend\": \"" << r.backend << "\", \"rows\": " << r.rows << ", \"cols\": " << r.cols
+            << ", \"charges\": " << (long)r.rows * r.cols << ", \"threads\": " << r.threads
+            << ", \"repeats\": " << r.repeats << ", \"median_us\": " << r.medianMicroseconds
+            << ", \"p99_us\": " << r.p99Microseconds << ", \"charges_per_sec\": " << r.chargesPerSecond
+            << ", \"efficiency\": ";
+        if (std::isnan(r.efficiency)) {
+            out << "null";
+        } else {
+            out << r.efficiency;
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+int main(int argc, char* argv[]) {
+    vector<int> sizes = {100, 300, 1000};
+    vector<int> threadCounts;
+    for (int t = 1; t <= omp_get_num_procs(); t *= 2) {
+        threadCounts.push_back(t);
+    }
+    if (threadCounts.back() != omp_get_num_procs()) {
+        threadCounts.push_back(omp_get_num_procs());
+    }
+    vector<string> backends = {"thread", "openmp", "batch", "tree"};
+    int repeats = 20;
+    string format = "csv";
+    string outputFile;
+    ECE_Affinity affinity;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-L") == 0 && i + 1 < argc) {
+            sizes = parseIntList(argv[++i]);
+        } else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+            threadCounts = parseIntList(argv[++i]);
+        } else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc) {
+            repeats = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc) {
+            backends = parseNameList(argv[++i]);
+        } else if (strcmp(argv[i], "-A") == 0 && i + 1 < argc) {
+            if (!affinity.setPolicy(argv[++i])) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-F") == 0 && i + 1 < argc) {
+            format = argv[++i];
+        } else if (strcmp(argv[i], "-O") == 0 && i + 1 < argc) {
+            outputFile = argv[++i];
+        } else {
+            cerr << "Usage: " << argv[0] << " [-L <sizes>] [-P <threads>] [-R <repeats>] [-B <backends>]"
+                 << " [-A <affinity>] [-F <csv|json>] [-O <output file>]" << endl;
+            return 1;
+        }
+    }
+
+    // Ascending, so the 1-thread baseline of every backend and size is measured before the efficiencies need it
+    sort(threadCounts.begin(), threadCounts.end());
+    threadCounts.erase(unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+    threadCounts.erase(threadCounts.begin(), lower_bound(threadCounts.begin(), threadCounts.end(), 1));
+    if (threadCounts.empty()) {
+        cerr << "No valid thread count given." << endl;
+        return 1;
+    }
+
+    vector<BenchResult> results;
+    const double x = 1.0, y = 2.0, z = 3.0;
+
+    for (int size : sizes) {
+        const int rows = size, cols = size;
+        const long max_num = (long)rows * cols;
+        const double xSeparation = 0.01, ySeparation = 0.03, q = 0.02;
+        const double halfRow = double(rows - 1.0) / 2.0 * ySeparation;
+        const double halfCol = double(cols - 1.0) / 2.0 * xSeparation;
+
+        // Written with the largest thread count and the kernels' static split (first touch)
+        ECE_ChargeArray charges;
+        charges.resize(max_num);
+        vector<ECE_ElectricField> vecElectric;
+        omp_set_num_threads(*max_element(threadCounts.begin(), threadCounts.end()));
+        #pragma omp parallel
+        {
+            affinity.pinThread(omp_get_thread_num());
+            long begin = max_num * omp_get_thread_num() / omp_get_num_threads();
+            long end = max_num * (omp_get_thread_num() + 1) / omp_get_num_threads();
+            for (long n = begin; n < end; ++n) {
+                int i = int(n / cols), j = int(n % cols);
+                charges.setCharge(n, j * xSeparation - halfCol, i * ySeparation - halfRow, 0, q);
+            }
+        }
+
+        vector<Point> pts(BATCH_POINTS);
+        vector<Field> out(BATCH_POINTS);
+        for (int p = 0; p < BATCH_POINTS; ++p) {
+            pts[p] = Point{x + 0.01 * p, y - 0.02 * p, z + 0.001 * p};
+        }
+        unique_ptr<ECE_ChargeTree> tree;
+
+        for (const string& backend : backends) {
+            double singleThreadMedian = 0.0;
+            for (int threads : threadCounts) {
+                if (backend == "object" && threads != 1) {
+                    continue;
+                }
+                omp_set_num_threads(threads);
+                omp_set_schedule(omp_sched_static, 0);
+                #pragma omp parallel
+                affinity.pinThread(omp_get_thread_num());
+                double Ex, Ey, Ez;
+                double pointsPerQuery = 1.0;
+                function<void()> query;
+                unique_ptr<ECE_ThreadPool> pool;
+                unique_ptr<ECE_ProbeMonitor> monitor;
+                vector<ChargeUpdate> updates;
+                vector<PartialField> partial(threads);
+                vector<vector<double>> threadSeconds(threads);
+                vector<int> threadNodes(threads, 0);
+                vector<int> pageNodes(threads, 0);
+                unique_ptr<double[]> streamData;
+
+                if (backend == "object") {
+                    if (vecElectric.empty()) {
+                        for (long i = 0; i < max_num; ++i) {
+                            vecElectric.push_back(ECE_ElectricField(charges.getX(i), charges.getY(i), 0, q));
+                        }
+                    }
+                    query = [&]() {
+                        double tempEx, tempEy, tempEz;
+                        Ex = Ey = Ez = 0.0;
+                        for (auto& point : vecElectric) {
+                            point.computeFieldAt(x, y, z);
+                            point.getElectricField(tempEx, tempEy, tempEz);
+                            Ex += tempEx;
+                            Ey += tempEy;
+                            Ez += tempEz;
+                        }
+                    };
+                } else if (backend == "thread") {
+                    pool.reset(new ECE_ThreadPool(threads - 1, affinity));
+                    query = [&]() {
+                        pool->run([&](int id) {
+                            size_t begin = max_num * id / threads, end = max_num * (id + 1) / threads;
+                            charges.computeFieldAt(x, y, z, begin, end, partial[id].Ex, partial[id].Ey,
+                                                   partial[id].Ez);
+                        });
+                    };
+                } else if (backend == "openmp") {
+                    query = [&]() { ECE_Autotuner::computeField(charges, x, y, z, Ex, Ey, Ez); };
+                } else if (backend == "batch") {
+                    pointsPerQuery = BATCH_POINTS;
+                    query = [&]() { charges.evaluateField(pts.data(), BATCH_POINTS, out.data()); };
+                } else if (backend == "single") {
+                    pointsPerQuery = BATCH_POINTS;
+                    charges.setSinglePrecision(true);
+                    query = [&]() { charges.evaluateField(pts.data(), BATCH_POINTS, out.data()); };
+                } else if (backend == "lattice") {
+                    pointsPerQuery = BATCH_POINTS;
+                    charges.setLattice(rows, cols, -halfCol, -halfRow, xSeparation, ySeparation);
+                    query = [&]() { charges.evaluateField(pts.data(), BATCH_POINTS, out.data()); };
+                } else if (backend == "update") {
+                    // Charges are rewritten in place, so the lattice is the same for the next backend
+                    monitor.reset(new ECE_ProbeMonitor(charges));
+                    monitor->addProbes(pts.data(), BATCH_POINTS);
+                    updates.clear();
+                    for (int u = 0; u < 8; ++u) {
+                        size_t index = max_num * u / 8;
+                        updates.push_back(ChargeUpdate{index, charges.getX(index), charges.getY(index),
+                                                       charges.getZ(index), q});
+                    }
+                    query = [&]() { monitor->applyUpdates(updates.data(), updates.size()); };
+                } else if (backend == "tree") {
+                    if (!tree) {
+                        tree.reset(new ECE_ChargeTree(charges));
+                    }
+                    pointsPerQuery = BATCH_POINTS;
+                    query = [&]() { tree->evaluateField(pts.data(), BATCH_POINTS, out.data()); };
+                } else if (backend == "stream") {
+                    // Fresh pages for every thread count, written and read with the same split, so each
+                    // slice sits where its reader first touched it; the page and CPU nodes are then looked up
+                    streamData.reset(new double[4 * max_num]);
+                    double* data = streamData.get();
+                    #pragma omp parallel
+                    {
+                        int id = omp_get_thread_num();
+                        long begin = 4 * (max_num * id / threads), end = 4 * (max_num * (id + 1) / threads);
+                        for (long n = begin; n < end; ++n) {
+                            data[n] = 1.0;
+                        }
+                        threadNodes[id] = affinity.getCurrentNode();
+                        pageNodes[id] = affinity.getNodeOfAddress(data + (begin + end) / 2);
+                    }
+                    query = [&]() {
+                        double sink = 0.0;
+                        #pragma omp parallel reduction(+:sink)
+                        {
+                            int id = omp_get_thread_num();
+                            long begin = 4 * (max_num * id / threads), end = 4 * (max_num * (id + 1) / threads);
+                            double start_time = omp_get_wtime();
+                            double s = 0.0;
+                            #pragma omp simd reduction(+:s)
+                            for (long n = begin; n < end; ++n) {
+                                s += data[n];
+                            }
+                            threadSeconds[id].push_back(omp_get_wtime() - start_time);
+                            sink += s;
+                        }
+                        streamSink += sink;
+                    };
+                } else {
+                    cerr << "Unknown backend: " << backend << endl;
+                    return 1;
+                }
+
+                vector<double> times = timeQuery(query, repeats);
+                pool.reset();
+                charges.setSinglePrecision(false);
+                charges.clearLattice();
+
+                BenchResult r;
+                r.backend = backend;
+                r.rows = rows;
+                r.cols = cols;
+                r.threads = threads;
+                r.repeats = repeats;
+                r.medianMicroseconds = times[times.size() / 2] / pointsPerQuery;
+                r.p99Microseconds = times[min(times.size() - 1, size_t(ceil(0.99 * times.size())) - 1)] / pointsPerQuery;
+                r.chargesPerSecond = max_num / (r.medianMicroseconds * 1e-6);
+                if (threads == 1) {
+                    singleThreadMedian = r.medianMicroseconds;
+                }
+                r.efficiency = singleThreadMedian > 0.0 ? singleThreadMedian / (threads * r.medianMicroseconds) : NAN;
+                results.push_back(r);
+                cerr << backend << " " << rows << "x" << cols << " " << threads << " threads: "
+                     << r.medianMicroseconds << " us\n";
+
+                // Per-node read bandwidth: the concurrent rates of the threads reading each node's pages,
+                // local readers (slot 0) apart from readers running on another node (slot 1)
+                if (backend == "stream") {
+                    const int numNodes = affinity.getNodeCount();
+                    vector<double> nodeRate(2 * numNodes, 0.0);
+                    vector<int> nodeThreads(2 * numNodes, 0);
+                    for (int id = 0; id < threads; ++id) {
+                        vector<double>& seconds = threadSeconds[id];
+                        sort(seconds.begin(), seconds.end());
+                        double median = seconds[seconds.size() / 2];
+                        long count = max_num * (id + 1) / threads - max_num * id / threads;
+                        int slot = 2 * pageNodes[id] + (threadNodes[id] != pageNodes[id] ? 1 : 0);
+                        if (median > 0.0) {
+                            nodeRate[slot] += count / median;
+                        }
+                        ++nodeThreads[slot];
+                    }
+                    for (int slot = 0; slot < 2 * numNodes; ++slot) {
+                        if (nodeThreads[slot] == 0) {
+                            continue;
+                        }
+                        BenchResult n = r;
+                        n.backend = "stream/node" + to_string(slot / 2) + (slot % 2 ? "/remote" : "");
+                        n.threads = nodeThreads[slot];
+                        n.chargesPerSecond = nodeRate[slot];
+                        n.efficiency = NAN;
+                        results.push_back(n);
+                        cerr << "  node " << slot / 2 << (slot % 2 ? " remote: " : ": ") << nodeThreads[slot]
+                             << " threads, " << nodeRate[slot] * 4 * sizeof(double) * 1e-9 << " GB/s\n";
+                    }
+                }
+            }
+        }
+    }
+
+    if (outputFile.empty()) {
+        format == "json" ? writeJSON(cout, results) : writeCSV(cout, results);
+    } else {
+        ofstream outFile(outputFile);
+        if (!outFile.is_open()) {
+            cerr << "Error: Unable to open file for writing: " << outputFile << endl;
+            return 1;
+        }
+        format == "json" ? writeJSON(outFile, results) : writeCSV(outFile, results);
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Converts a CSV charge list into the binary charge-set file read by
+my_program -C and mpi_solver -C. Each line holds "x,y,z,q" with the
+location in meters and the charge in micro Coulomb; spaces or tabs may
+replace the commas. Empty lines, lines starting with '#' and lines that
+do not hold four numbers (such as a header) are skipped.
+
+The input is read twice: once to count the charges and once to write
+them straight into the mapped output file, so memory use does not depend
+on the number of charges.
+
+Usage: convert_charges <input.csv> <output file>
+
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "ECE_ChargeFile.h"
+
+using namespace std;
+
+/**
+ * Parses one line of the CSV file.
+ *
+ * @param line      The NUL-terminated line.
+ * @param values    Array to store x, y, z and q.
+ * @return          True if the line holds four numbers, false otherwise.
+ */
+bool parseCharge(char* line, double values[4]) {
+    char* p = line;
+    for (int v = 0; v < 4; ++v) {
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            ++p;
+        }
+        if (*p == '#') {
+            return false;
+        }
+        char* end;
+        values[v] = strtod(p, &end);
+        if (end == p) {
+            return false;
+        }
+        p = end;
+    }
+    while (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r' || *p == '\n') {
+        ++p;
+    }
+    return *p == '\0';
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        cerr << "Usage: " << argv[0] << " <input.csv> <output file>" << endl;
+        return 1;
+    }
+
+    FILE* input = fopen(argv[1], "r");
+    if (input == nullptr) {
+        cerr << "Error: Unable to open file for reading: " << argv[1] << endl;
+        return 1;
+    }
+
+    char* line = nullptr;
+    size_t capacity = 0;
+    double values[4];
+
+    // First pass: count the charges
+    size_t count = 0, skipped = 0;
+    while (getline(&line, &capacity, input) != -1) {
+        if (parseCharge(line, values)) {
+            ++count;
+        } else {
+            ++skipped;
+        }
+    }
+
+    // Second pass: write them into the mapped output
+    {
+        ECE_ChargeFile output(argv[2], count);
+        if (!output.isOpen()) {
+            free(line);
+            fclose(input);
+            return 1;
+        }
+        double* arrays[4];
+        for (int axis = 0; axis < 4; ++axis) {
+            arrays[axis] = output.getWritableArray(axis);
+        }
+        rewind(input);
+        size_t i = 0;
+        while (i < count && getline(&line, &capacity, input) != -1) {
+            if (parseCharge(line, values)) {
+                arrays[0][i] = values[0];
+                arrays[1][i] = values[1];
+                arrays[2][i] = values[2];
+                arrays[3][i] = values[3] * 1.0e-6;
+                ++i;
+            }
+        }
+        if (i != count) {
+            cerr << "Error: " << argv[1] << " changed while it was converted." << endl;
+            free(line);
+            fclose(input);
+            return 1;
+        }
+    }
+    free(line);
+    fclose(input);
+
+    cout << "Converted " << count << " charges to " << argv[2];
+    if (skipped > 0) {
+        cout << " (skipped " << skipped << " lines)";
+    }
+    cout << endl;
+    return 0;
+}
@@ -1,6 +1,6 @@
 // /*
 // Author:  Yang Gu
-// Date last modified: 03/10/2023
+// Date last modified: 17/10/2026
 // Organization: ECE6122 Class
 
 // Description:
@@ -14,21 +14,46 @@
 #include <vector>
 #include <iomanip>
 #include <omp.h>
+#include <climits>
 
 #include "utils.h"
 #include "ECE_ElectricField.h"
+#include "ECE_ChargeArray.h"
+#include "ECE_ChargeTree.h"
+#include "ECE_FieldVolume.h"
+#include "ECE_EwaldSum.h"
+#include "ECE_FieldLineTracer.h"
+#include "ECE_ChargeDynamics.h"
+#include "ECE_FieldMap.h"
+#include "ECE_Autotuner.h"
+#include "ECE_QueryStream.h"
+#include "ECE_ResultWriter.h"
+#include "ECE_FieldTerms.h"
+#include "ECE_PairwiseSum.h"
+#include "ECE_Affinity.h"
+#include "ECE_QueryProfiler.h"
+#include <memory>
 
 using namespace std;
 
-int main() {
-    // Declaration of a vector to store electric field values
-    vector<ECE_ElectricField> vecElectric;
+const size_t GRID_BLOCK = 65536; // probe-grid points per batched query, the block size of ECE_QueryStream
+
+int main(int argc, char* argv[]) {
+    // Backend selection from the command line
+    SolverOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    // Structure-of-arrays store for the charge locations and values
+    ECE_ChargeArray charges;
 
     // Variable declarations for grid specifications and other parameters
     int rows, cols, numOfThreads;
     double q, xSeparation, ySeparation;
 
     // Input section; uses a preset string for debugging or prompts user for real-time input
+    const bool fromFile = !options.chargeFile.empty();
 #ifdef DEBUG
     string input = "16 \n 1000 1000 \n 0.01 0.03 \n 0.02 \n";
     istringstream iss(input);
@@ -38,29 +63,369 @@ int main() {
     iss >> xSeparation >> ySeparation;
     iss >> q;
 #else
-    getBasicInfo(numOfThreads, rows, cols, xSeparation, ySeparation, q);
+    if (options.latticeGiven) {
+        numOfThreads = options.threads;
+        rows = options.rows;
+        cols = options.cols;
+        xSeparation = options.xSeparation;
+        ySeparation = options.ySeparation;
+        q = options.q;
+    } else if (!fromFile) {
+        getBasicInfo(numOfThreads, rows, cols, xSeparation, ySeparation, q);
+    }
 #endif
 
+    // Charges from a mapped charge-set file replace the lattice; they are kept as 1 row of n charges
+    if (fromFile) {
+        if (!charges.mapFile(options.chargeFile)) {
+            return 1;
+        }
+        if (charges.size() == 0 || charges.size() > size_t(INT_MAX)) {
+            cerr << "The charge-set file must hold between 1 and " << INT_MAX << " charges." << endl;
+            return 1;
+        }
+        numOfThreads = options.latticeGiven ? options.threads : omp_get_max_threads();
+        rows = 1;
+        cols = int(charges.size());
+        xSeparation = ySeparation = q = 0.0;
+    }
+
+    // Field-map mode: the whole observation plane by FFT convolution over the lattice
+    if (!options.mapFile.empty()) {
+        omp_set_num_threads(numOfThreads);
+        double map_start = omp_get_wtime();
+        ECE_FieldMap fieldMap(rows, cols, xSeparation, ySeparation, q, options.mapMargin);
+        fieldMap.compute(options.mapHeight);
+        double map_end = omp_get_wtime();
+        cout << "The " << fieldMap.getMapRows() << " x " << fieldMap.getMapCols() << " field map at z = "
+             << options.mapHeight << " took " << (map_end - map_start)*1e6 << " microseconds!\n";
+        if (!fieldMap.save(options.mapFile)) {
+            return 1;
+        }
+        cout << "Field map saved to " << options.mapFile << endl;
+        return 0;
+    }
+
     int max_num = cols * rows;
-    vecElectric.reserve(max_num);   // Reserve memory for electric field values
+    if (!fromFile) {
+        charges.resize(max_num);   // Allocate the charge arrays
+    }
 
     // Ensuring the number of threads is not greater than the number of grid points
     numOfThreads = max_num > numOfThreads ? numOfThreads : max_num;
     omp_set_num_threads(numOfThreads);
-    int num_per_thread = max_num/numOfThreads;
+
+    // Optional pinning of the OpenMP threads, which the runtime keeps between parallel regions
+    ECE_Affinity affinity;
+    if (!affinity.setPolicy(options.affinity)) {
+        return 1;
+    }
+    #pragma omp parallel
+    affinity.pinThread(omp_get_thread_num());
 
     const double halfRow = double(rows - 1.0) / 2.0 * ySeparation;
     const double halfCol = double(cols - 1.0) / 2.0 * xSeparation;
 
-    // Parallel computation to populate the vecElectric with ECE_ElectricField objects
-    #pragma omp parallel for
-        for (int i = 0; i < rows; ++i) {
-            for (int j = 0; j < cols; ++j) {
+    // Parallel computation to populate the charge array; every thread writes the range it
+    // sums in the kernels, so first touch puts the range on that thread's NUMA node.
+    // The generated lattice is regular, planar and uniform: its double queries generate the positions
+    if (!fromFile) {
+        #pragma omp parallel
+        {
+            const size_t begin = size_t(max_num) * omp_get_thread_num() / omp_get_num_threads();
+            const size_t end = size_t(max_num) * (omp_get_thread_num() + 1) / omp_get_num_threads();
+            for (size_t n = begin; n < end; ++n) {
+                const int i = int(n / cols), j = int(n % cols);
                 double chargeX = j*xSeparation - halfCol;
                 double chargeY = i*ySeparation - halfRow;
-                vecElectric[i * cols + j] = ECE_ElectricField(chargeX, chargeY, 0, q);
+                charges.setCharge(n, chargeX, chargeY, 0, q);
+            }
+        }
+        charges.setLattice(rows, cols, -halfCol, -halfRow, xSeparation, ySeparation);
+    }
+
+    // Streamed results may go to stdout, so the reports of batch mode go to stderr, as do those of field lines
+    const bool batchMode = !options.queryFile.empty() || options.gridGiven;
+    ostream& report = batchMode || !options.seedFile.empty() ? cerr : cout;
+
+    // Build the Barnes-Hut octree once when it is selected as the backend
+    unique_ptr<ECE_ChargeTree> tree;
+    const bool useTree = options.backend == "tree";
+    if (useTree) {
+        double build_start = omp_get_wtime();
+        tree.reset(new ECE_ChargeTree(charges, options.theta));
+        report << "Building the charge tree (" << tree->getNodeCount() << " nodes, theta = " << options.theta
+             << ") took " << (omp_get_wtime() - build_start)*1e6 << " microseconds!\n";
+    }
+
+    // Precomputed field volume; queries inside its box are interpolated in O(1)
+    unique_ptr<ECE_FieldVolume> volume;
+    const bool useVolume = options.backend == "volume";
+    if (useVolume) {
+        const double* box = options.volumeBox;
+        // Grade towards the plane on the scale of the lattice spacing, or of 1% of the box for a charge file
+        double zScale = options.volumeZScale;
+        if (zScale < 0.0) {
+            zScale = fromFile ? 0.01 * max(box[1] - box[0], box[3] - box[2]) : min(xSeparation, ySeparation);
+        }
+        double build_start = omp_get_wtime();
+        volume.reset(new ECE_FieldVolume(charges));
+        volume->build(box[0], box[1], box[2], box[3], box[4], box[5],
+                      options.volumeNodes[0], options.volumeNodes[1], options.volumeNodes[2], zScale);
+        report << "Building the field volume (" << volume->getNodeCount() << " nodes, z spacing "
+               << volume->getMinZSpacing() << " to " << volume->getMaxZSpacing() << ") took "
+               << (omp_get_wtime() - build_start)*1e6 << " microseconds!\n";
+        report << "Field volume: largest relative interpolation error at 4096 cell centres is "
+               << volume->estimateError(4096) << "\n";
+    }
+
+    // Infinite periodic sheet of the lattice cell, summed with the 2D Ewald method; rows and cols only
+    // place the sheet, whose charges coincide with those of the finite lattice
+    unique_ptr<ECE_EwaldSum> ewald;
+    const bool useEwald = options.backend == "ewald";
+    if (useEwald) {
+        double realCutoff = options.ewaldRealCutoff, reciprocalCutoff = options.ewaldReciprocalCutoff;
+        if (realCutoff <= 0.0) {
+            ECE_EwaldSum::chooseCutoffs(xSeparation, ySeparation, 1e-12, realCutoff, reciprocalCutoff);
+        }
+        ewald.reset(new ECE_EwaldSum(xSeparation, ySeparation, -halfCol, -halfRow, q, realCutoff, reciprocalCutoff));
+        report << "Ewald sum of the periodic sheet: alpha = " << ewald->getAlpha() << " 1/m, real cutoff "
+               << ewald->getRealCutoff() << " m, reciprocal cutoff " << ewald->getReciprocalCutoff() << " 1/m, "
+               << ewald->getTermCount() << " terms per query\n";
+    }
+
+    // Opt-in reproducible sums: fixed charge blocks added with a pairwise tree, whatever the thread count
+    charges.setDeterministic(options.deterministic);
+
+    // Opt-in float kernel; its error is measured on a probe grid just above the charges
+    if (options.singlePrecision && !useTree && !useEwald) {
+        charges.setSinglePrecision(true);
+        double minX = charges.getX(0), maxX = minX, minY = charges.getY(0), maxY = minY, maxZ = charges.getZ(0);
+        for (size_t i = 1; i < charges.size(); ++i) {
+            minX = min(minX, charges.getX(i));
+            maxX = max(maxX, charges.getX(i));
+            minY = min(minY, charges.getY(i));
+            maxY = max(maxY, charges.getY(i));
+            maxZ = max(maxZ, charges.getZ(i));
+        }
+        // One lattice spacing above a lattice, 1% of the extent above a charge set
+        const double gap = fromFile ? 0.01 * max(max(maxX - minX, maxY - minY), 1e-6) : min(xSeparation, ySeparation);
+        vector<Point> probes;
+        for (int i = 0; i < 8; ++i) {
+            for (int j = 0; j < 8; ++j) {
+                probes.push_back(Point{minX - gap + j / 7.0 * (maxX - minX + 2.0 * gap),
+                                       minY - gap + i / 7.0 * (maxY - minY + 2.0 * gap), maxZ + gap});
+            }
+        }
+        report << "Single precision: largest relative error against double on " << probes.size()
+               << " probe points is " << charges.measureSinglePrecisionError(probes.data(), probes.size()) << "\n";
+    }
+
+    // Field-line mode: all lines advance together, every RK45 stage is one batched query
+    if (!options.seedFile.empty()) {
+        ECE_QueryStream seedStream(options.seedFile);
+        if (!seedStream.isOpen()) {
+            return 1;
+        }
+        vector<Point> seeds, block;
+        while (seedStream.next(block)) {
+            seeds.insert(seeds.end(), block.begin(), block.end());
+        }
+        TraceSettings settings;
+        settings.maxLength = options.lineLength;
+        settings.tolerance = options.lineTolerance;
+        settings.maxStep = options.lineLength / 20.0;
+        settings.initialStep = min(settings.maxStep, 100.0 * options.lineTolerance);
+        settings.minStep = 1e-3 * options.lineTolerance;
+        ECE_FieldLineTracer tracer([&](const Point* pts, size_t m, Field* out) {
+            if (useTree) {
+                tree->evaluateField(pts, m, out);
+            } else if (useVolume) {
+                volume->evaluateField(pts, m, out);
+            } else if (useEwald) {
+                ewald->evaluateField(pts, m, out);
+            } else {
+                charges.evaluateField(pts, m, out);
             }
+        }, settings);
+        double trace_start = omp_get_wtime();
+        tracer.trace(seeds.data(), seeds.size());
+        double trace_time = omp_get_wtime() - trace_start;
+        size_t ended[5] = {0, 0, 0, 0, 0};
+        for (size_t i = 0; i < tracer.getLineCount(); ++i) {
+            ++ended[tracer.getEndReason(i)];
         }
+        cerr << "Traced " << tracer.getLineCount() << " field lines (" << tracer.getVertexCount() << " vertices, "
+             << tracer.getAcceptedSteps() << " steps, " << tracer.getRejectedSteps() << " rejected) in "
+             << trace_time*1e6 << " microseconds\n"
+             << tracer.getBatchCount() << " batched queries of " << tracer.getEvaluatedPoints() << " points ("
+             << (trace_time > 0.0 ? tracer.getEvaluatedPoints() / trace_time : 0.0) << " points/s)\n"
+             << "Lines ended at the maximum length: " << ended[ECE_FieldLineTracer::MAX_LENGTH]
+             << ", step count: " << ended[ECE_FieldLineTracer::MAX_STEPS]
+             << ", zero field: " << ended[ECE_FieldLineTracer::ZERO_FIELD]
+             << ", minimum step: " << ended[ECE_FieldLineTracer::MIN_STEP] << "\n";
+        if (!tracer.save(options.lineFile)) {
+            return 1;
+        }
+        cerr << "Field lines saved to " << options.lineFile << endl;
+        return 0;
+    }
+
+    // N-body mode: the charges move under their mutual softened Coulomb forces
+    if (options.dynamicsSteps > 0) {
+        ECE_ChargeDynamics dynamics(charges, options.mass, options.softening);
+        if (!dynamics.openCheckpoints(options.checkpointFile) || !dynamics.writeCheckpoint()) {
+            return 1;
+        }
+        const double initialEnergy = dynamics.getKineticEnergy() + dynamics.getPotentialEnergy();
+        report << "Step        Time (s)   Kinetic (J)  Potential (J)      Total (J)  Relative drift\n";
+        report << scientific << setprecision(6);
+        report << setw(4) << 0 << setw(16) << 0.0 << setw(14) << dynamics.getKineticEnergy() << setw(15)
+               << dynamics.getPotentialEnergy() << setw(15) << initialEnergy << setw(16) << 0.0 << "\n";
+        double run_start = omp_get_wtime();
+        for (int s = 1; s <= options.dynamicsSteps; ++s) {
+            const bool checkpoint = s % options.checkpointEvery == 0 || s == options.dynamicsSteps;
+            dynamics.step(options.timeStep, checkpoint);
+            if (checkpoint) {
+                if (!dynamics.writeCheckpoint()) {
+                    cerr << "Error: Unable to write checkpoint to " << options.checkpointFile << endl;
+                    return 1;
+                }
+                const double kinetic = dynamics.getKineticEnergy();
+                const double potential = dynamics.getPotentialEnergy();
+                const double total = kinetic + potential;
+                report << setw(4) << s << setw(16) << dynamics.getTime() << setw(14) << kinetic << setw(15)
+                       << potential << setw(15) << total << setw(16)
+                       << (initialEnergy != 0.0 ? (total - initialEnergy) / fabs(initialEnergy) : 0.0) << "\n";
+            }
+        }
+        double run_time = omp_get_wtime() - run_start;
+        report << defaultfloat << setprecision(6);
+        report << dynamics.getStepCount() << " steps of " << charges.size() << " charges took " << run_time*1e6
+               << " microseconds, " << dynamics.getForceSeconds()*1e6 << " of them in the force kernel ("
+               << (dynamics.getForceSeconds() > 0.0 ? dynamics.getPairInteractions() / dynamics.getForceSeconds() : 0.0)
+               << " pair interactions/s)\n";
+        report << "Checkpoints saved to " << options.checkpointFile << endl;
+        return 0;
+    }
+
+    // Batch mode: blocks of streamed points or of the probe grid through the batched query, parsing overlapped
+    // by the reader thread, and formatting and writing by the I/O thread of the writer
+    if (batchMode) {
+        unique_ptr<ECE_QueryStream> queries;
+        ProbeGrid grid;
+        if (options.gridGiven) {
+            copy(options.gridBox, options.gridBox + 6, grid.box);
+            copy(options.gridNodes, options.gridNodes + 3, grid.nodes);
+        } else {
+            queries.reset(new ECE_QueryStream(options.queryFile));
+        }
+        ECE_ResultWriter writer(options.outputFile, options.allTerms, options.gridGiven ? &grid : nullptr);
+        if ((queries && !queries->isOpen()) || !writer.isOpen()) {
+            return 1;
+        }
+        size_t gridIndex = 0;
+        auto nextBlock = [&](vector<Point>& block) {
+            if (queries) {
+                return queries->next(block);
+            }
+            // x fastest, then y, then z, the order of VTK structured points
+            const size_t count = min(GRID_BLOCK, grid.size() - gridIndex);
+            const size_t nx = grid.nodes[0], ny = grid.nodes[1];
+            block.resize(count);
+            for (size_t i = 0; i < count; ++i, ++gridIndex) {
+                block[i] = Point{grid.box[0] + double(gridIndex % nx) * grid.spacing(0),
+                                 grid.box[2] + double(gridIndex / nx % ny) * grid.spacing(1),
+                                 grid.box[4] + double(gridIndex / (nx * ny)) * grid.spacing(2)};
+            }
+            return count > 0;
+        };
+        vector<Point> block;
+        vector<Field> fields;
+        vector<FieldTerms> terms;
+        size_t numPoints = 0;
+        double computeTime = 0.0;
+        double batch_start = omp_get_wtime();
+        while (nextBlock(block)) {
+            double block_start = omp_get_wtime();
+            bool written;
+            if (options.allTerms) {
+                // V, E and the field gradient in one fused sweep
+                terms.resize(block.size());
+                evaluateTerms<OUTPUT_ALL>(charges, block.data(), block.size(), terms.data());
+                computeTime += omp_get_wtime() - block_start;
+                written = writer.write(block.data(), terms.data(), block.size());
+            } else {
+                fields.resize(block.size());
+                if (useTree) {
+                    tree->evaluateField(block.data(), block.size(), fields.data());
+                } else if (useVolume) {
+                    volume->evaluateField(block.data(), block.size(), fields.data());
+                } else if (useEwald) {
+                    ewald->evaluateField(block.data(), block.size(), fields.data());
+                } else {
+                    charges.evaluateField(block.data(), block.size(), fields.data());
+                }
+                computeTime += omp_get_wtime() - block_start;
+                written = writer.write(block.data(), fields.data(), block.size());
+            }
+            if (!written) {
+                cerr << "Error: Unable to write the results to " << options.outputFile << endl;
+                // Release a reader blocked on the full queue before it is joined
+                if (queries) {
+                    queries->close();
+                }
+                return 1;
+            }
+            numPoints += block.size();
+        }
+        if (!writer.close()) {
+            cerr << "Error: Unable to write the results to " << options.outputFile << endl;
+            return 1;
+        }
+        double batch_time = omp_get_wtime() - batch_start;
+        cerr << "Evaluated " << numPoints << " points in " << batch_time*1e6 << " microseconds ("
+             << computeTime*1e6 << " computing, " << writer.getWaitSeconds()*1e6 << " waiting for the output, "
+             << (batch_time > 0.0 ? numPoints / batch_time : 0.0) << " points/s)\n";
+        if (queries && queries->getSkippedLines() > 0) {
+            cerr << "Skipped " << queries->getSkippedLines() << " malformed lines in " << options.queryFile << "\n";
+        }
+        return 0;
+    }
+
+    // Thread count and loop schedule; a balanced static split unless a tuned configuration is used
+    omp_set_schedule(omp_sched_static, 0);
+    if (!options.tuneFile.empty() && !useTree && !useVolume && !useEwald) {
+        ECE_Autotuner tuner(options.tuneFile);
+        TuningConfig config;
+        if (tuner.load(rows, cols, config)) {
+            cout << "Using the tuned configuration from " << options.tuneFile << ": "
+                 << ECE_Autotuner::describe(config) << "\n";
+        } else {
+            cout << "Autotuning the field query for a " << rows << " x " << cols << " lattice:\n";
+            config = tuner.tune(charges, max(omp_get_num_procs(), numOfThreads));
+            cout << "Best configuration: " << ECE_Autotuner::describe(config) << ", "
+                 << config.microseconds << " microseconds\n";
+            if (tuner.save(rows, cols, config)) {
+                cout << "Configuration saved to " << options.tuneFile << endl;
+            }
+        }
+        numOfThreads = min(config.threads, max_num);
+        omp_set_num_threads(numOfThreads);
+        omp_set_schedule(config.schedule, config.chunk);
+        #pragma omp parallel
+        affinity.pinThread(omp_get_thread_num());
+    }
+    const long numBlocks = long((max_num + ECE_Autotuner::SCHEDULE_BLOCK - 1) / ECE_Autotuner::SCHEDULE_BLOCK);
+    // Deterministic mode keeps the Ex, Ey and Ez of every block, summed pairwise in block order
+    const bool blockSums = options.deterministic && !useTree && !useVolume && !useEwald;
+    vector<double> blockFields(blockSums ? 3 * numBlocks : 0);
+
+    // Optional per-thread compute and wait times, charge counts and hardware counters of every query
+    unique_ptr<ECE_QueryProfiler> profiler;
+    if (options.instrument) {
+        profiler.reset(new ECE_QueryProfiler(numOfThreads));
+    }
 
     double start_time, end_time;
     double Ex = 0.0, Ey = 0.0, Ez = 0.0;
@@ -70,12 +435,6 @@ int main() {
     // Parallel block for computing electric field at specific points and printing results
     #pragma omp parallel shared(x, y, z, Ex, Ey, Ez, continueLoop)
     {
-        int id = omp_get_thread_num();
-        unsigned long start_index = id * num_per_thread;
-        unsigned long stop_index = start_index + num_per_thread;
-        stop_index = stop_index > max_num ? max_num : stop_index;
-        double tempEx = 0.0, tempEy = 0.0, tempEz = 0.0;
-
         while (continueLoop)
         {   
             Ex = 0.0;
@@ -93,6 +452,9 @@ int main() {
 #else
                 getXYZ(x, y, z);
 #endif
+                if (profiler) {
+                    profiler->reset();
+                }
                 start_time = omp_get_wtime();
             }
             
@@ -100,28 +462,93 @@ int main() {
             sumEx = 0.0;
             sumEy = 0.0;
             sumEz = 0.0;
+            const int id = omp_get_thread_num();
+            unsigned long numCharges = 0;
+            if (profiler) {
+                profiler->beginCompute(id);
+            }
 
-            for (int i = start_index; i < stop_index; ++i){
-                vecElectric[i].computeFieldAt(x, y, z);
-                vecElectric[i].getElectricField(tempEx, tempEy, tempEz);
-                sumEx += tempEx;
-                sumEy += tempEy;
-                sumEz += tempEz;
+            if (useTree) {
+                // A tree walk for one point is O(log N), the master thread answers it alone
+                #pragma omp master
+                {
+                    tree->computeFieldAt(x, y, z, sumEx, sumEy, sumEz);
+                    numCharges = max_num;
+                }
+            } else if (useVolume) {
+                // An interpolated point is O(1), also answered by the master thread alone
+                #pragma omp master
+                {
+                    volume->computeFieldAt(x, y, z, sumEx, sumEy, sumEz);
+                    numCharges = 0;
+                }
+            } else if (useEwald) {
+                // A few hundred Ewald terms, also answered by the master thread alone
+                #pragma omp master
+                {
+                    ewald->computeFieldAt(x, y, z, sumEx, sumEy, sumEz);
+                    numCharges = ewald->getTermCount();
+                }
+            } else {
+                // Blocks of charges shared out with the runtime schedule, covering every charge
+                #pragma omp for schedule(runtime) nowait
+                for (long b = 0; b < numBlocks; ++b) {
+                    double tempEx, tempEy, tempEz;
+                    unsigned long start_index = b * ECE_Autotuner::SCHEDULE_BLOCK;
+                    unsigned long stop_index = min((unsigned long)max_num, start_index + ECE_Autotuner::SCHEDULE_BLOCK);
+                    charges.computeFieldAt(x, y, z, start_index, stop_index, tempEx, tempEy, tempEz);
+                    if (blockSums) {
+                        blockFields[3 * b] = tempEx;
+                        blockFields[3 * b + 1] = tempEy;
+                        blockFields[3 * b + 2] = tempEz;
+                    } else {
+                        sumEx += tempEx;
+                        sumEy += tempEy;
+                        sumEz += tempEz;
+                    }
+                    numCharges += stop_index - start_index;
+                }
             }
 
-            // Aggregate results from all threads
-            #pragma omp critical
-            {
-                    Ex += sumEx;
-                    Ey += sumEy;
-                    Ez += sumEz;
+            // Aggregate results from all threads; with a profiler the critical section and
+            // the barrier count as waiting
+            double wait_start = 0.0;
+            if (profiler) {
+                profiler->endCompute(id, numCharges);
+                wait_start = ECE_QueryProfiler::now();
+            }
+            if (!blockSums) {
+                #pragma omp critical
+                {
+                        Ex += sumEx;
+                        Ey += sumEy;
+                        Ez += sumEz;
+                }
             }
             #pragma omp barrier
+            if (profiler) {
+                // Every thread takes this branch, so the extra barrier is reached by all of them
+                profiler->addWait(id, ECE_QueryProfiler::now() - wait_start);
+                #pragma omp barrier
+            }
 
             // Master thread printing the results and asking the user for continuation
             #pragma omp master
             {
-
+                if (blockSums) {
+                    // Ex, Ey and Ez of the blocks combined by the pairwise tree of the batched queries
+                    double total[3];
+                    pairwiseBlockSum(0, size_t(numBlocks), 3, 0.0, total,
+                                     [&](size_t b, double* out) {
+                                         for (int a = 0; a < 3; ++a) {
+                                             out[a] += blockFields[3 * b + a];
+                                         }
+                                     },
+                                     [](double& sum, double value) { sum += value; }, false);
+                    Ex = total[0];
+                    Ey = total[1];
+                    Ez = total[2];
+                }
                 Enorm = sqrt(Ex * Ex + Ey * Ey + Ez * Ez);
                 end_time = omp_get_wtime();
                 
@@ -131,6 +558,19 @@ int main() {
                 cout << "Ez = " << formatScientific(Ez) << "\n";
                 cout << "|E| = " << formatScientific(Enorm) << "\n";
                 cout << "The calculation took " << (end_time - start_time)*1e6 << " microseconds!\n";
+                if (profiler) {
+                    profiler->report(cout);
+                }
+
+#ifdef DEBUG
+                // Cross-check the batched query path against the per-point result
+                Point probe = {x, y, z};
+                Field batched;
+                charges.evaluateField(&probe, 1, &batched);
+                double err = sqrt((batched.Ex - Ex) * (batched.Ex - Ex) + (batched.Ey - Ey) * (batched.Ey - Ey)
+                                  + (batched.Ez - Ez) * (batched.Ez - Ez));
+                cout << "Batched query relative difference: " << err / Enorm << "\n";
+#endif
 
                 // Checking if the user wants to continue
 #ifdef DEBUG
@@ -0,0 +1,226 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Distributed electric-field solver. Every MPI rank generates only its own
+band of lattice rows, or maps only its own slice of a charge-set file
+(-C), so no node ever holds the whole charge set. Rank 0
+reads the queries (the interactive prompts or a streamed query file) and
+broadcasts them block by block; each rank sums the field of its shard with
+the OpenMP batched kernel, and the partial fields are added together on
+rank 0 with MPI_Reduce.
+
+Usage: mpirun -np <ranks> ./mpi_solver [-B <direct|tree>] [-T <opening angle>] [-S]
+                                       [-L <threads> <rows> <cols> <x sep> <y sep> <q>]
+                                       [-C <charge file>] [-Q <query file>] [-O <output file>]
+The thread count is per rank; with -C it comes from -L or OMP_NUM_THREADS.
+
+*/
+
+#include <mpi.h>
+#include <omp.h>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "utils.h"
+#include "ECE_ChargeArray.h"
+#include "ECE_ChargeFile.h"
+#include "ECE_ChargeTree.h"
+#include "ECE_QueryStream.h"
+#include "ECE_ResultWriter.h"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    // Every rank parses the options itself; only rank 0 reports errors
+    SolverOptions options;
+    if (!parseOptions(argc, argv, options) || !options.mapFile.empty() || !options.tuneFile.empty()
+        || options.allTerms || options.volumeGiven || options.affinity != "none" || options.instrument
+        || !options.seedFile.empty() || options.dynamicsSteps > 0 || options.backend == "ewald"
+        || options.deterministic || options.gridGiven) {
+        if (rank == 0 && (!options.mapFile.empty() || !options.tuneFile.empty() || options.allTerms
+                          || options.volumeGiven || options.affinity != "none" || options.instrument
+                          || !options.seedFile.empty() || options.dynamicsSteps > 0
+                          || options.backend == "ewald" || options.deterministic || options.gridGiven)) {
+            cerr << "The field-map (-F), autotuning (-A), gradient (-G), volume (-V), pinning (-P),"
+                 << " instrumentation (-I), field-line (-R), N-body (-N), Ewald (-B ewald), deterministic (-D)"
+                 << " and probe-grid (-W) modes are not available in the distributed solver." << endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    // Lattice parameters from the command line, or prompted on rank 0 and broadcast
+    int intParams[3];
+    double realParams[3];
+    if (rank == 0) {
+        if (options.latticeGiven) {
+            intParams[0] = options.threads;
+            intParams[1] = options.rows;
+            intParams[2] = options.cols;
+            realParams[0] = options.xSeparation;
+            realParams[1] = options.ySeparation;
+            realParams[2] = options.q;
+        } else if (options.chargeFile.empty()) {
+            getBasicInfo(intParams[0], intParams[1], intParams[2], realParams[0], realParams[1], realParams[2]);
+        } else {
+            intParams[0] = omp_get_max_threads();
+        }
+    }
+    MPI_Bcast(intParams, 3, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(realParams, 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    const int numOfThreads = intParams[0], rows = intParams[1], cols = intParams[2];
+    const double xSeparation = realParams[0], ySeparation = realParams[1], q = realParams[2];
+    omp_set_num_threads(numOfThreads);
+
+    double setup_start = MPI_Wtime();
+    ECE_ChargeArray charges;
+    unsigned long long totalCharges = 0;
+    int loaded = 1;
+    if (!options.chargeFile.empty()) {
+        // This rank's shard: a contiguous slice of the file; the other slices are never touched
+        size_t count = 0;
+        loaded = ECE_ChargeFile::readCount(options.chargeFile, count)
+                 && charges.mapFile(options.chargeFile, count * rank / size, count * (rank + 1) / size);
+        totalCharges = count;
+    } else {
+        // This rank's shard: a contiguous band of rows
+        const int firstRow = int(long(rows) * rank / size);
+        const int lastRow = int(long(rows) * (rank + 1) / size);
+        const double halfRow = double(rows - 1.0) / 2.0 * ySeparation;
+        const double halfCol = double(cols - 1.0) / 2.0 * xSeparation;
+        totalCharges = (unsigned long long)rows * cols;
+        charges.resize(size_t(lastRow - firstRow) * cols);
+        #pragma omp parallel for
+        for (int i = firstRow; i < lastRow; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                charges.setCharge(size_t(i - firstRow) * cols + j, j * xSeparation - halfCol,
+                                  i * ySeparation - halfRow, 0, q);
+            }
+        }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &loaded, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if (!loaded) {
+        MPI_Finalize();
+        return 1;
+    }
+    const bool useTree = options.backend == "tree";
+    unique_ptr<ECE_ChargeTree> tree;
+    if (useTree && charges.size() > 0) {
+        tree.reset(new ECE_ChargeTree(charges, options.theta));
+    }
+    if (options.singlePrecision && !useTree) {
+        charges.setSinglePrecision(true);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    // Streamed results may go to stdout, so the reports of batch mode go to stderr
+    const bool batchMode = !options.queryFile.empty();
+    ostream& report = batchMode ? cerr : cout;
+    if (rank == 0) {
+        report << "Set up " << size << " shards of about " << totalCharges / size << " charges in "
+               << (MPI_Wtime() - setup_start)*1e6 << " microseconds!\n";
+    }
+
+    unique_ptr<ECE_QueryStream> queries;
+    unique_ptr<ECE_ResultWriter> writer;
+    if (rank == 0 && batchMode) {
+        queries.reset(new ECE_QueryStream(options.queryFile));
+        writer.reset(new ECE_ResultWriter(options.outputFile));
+    }
+    int opened = rank != 0 || !batchMode || (queries->isOpen() && writer->isOpen());
+    MPI_Bcast(&opened, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (!opened) {
+        MPI_Finalize();
+        return 1;
+    }
+
+    vector<Point> block;
+    vector<Field> partial, total;
+    unsigned long long numPoints = 0;
+    double batch_start = MPI_Wtime();
+    while (true) {
+        // Rank 0 fetches the next block; an empty block ends the run on every rank
+        unsigned long long m = 0;
+        if (rank == 0) {
+            if (batchMode) {
+                m = queries->next(block) ? block.size() : 0;
+            } else if (numPoints == 0 || getChoice()) {
+                double x, y, z;
+                getXYZ(x, y, z);
+                block.assign(1, Point{x, y, z});
+                m = 1;
+            } else {
+                cout << "Bye!" << endl;
+            }
+        }
+        MPI_Bcast(&m, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+        if (m == 0) {
+            break;
+        }
+        block.resize(m);
+        MPI_Bcast(block.data(), int(3 * m), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+        double start_time = MPI_Wtime();
+        partial.assign(m, Field{0.0, 0.0, 0.0});
+        if (useTree) {
+            if (tree) {
+                tree->evaluateField(block.data(), m, partial.data());
+            }
+        } else {
+            charges.evaluateField(block.data(), m, partial.data());
+        }
+        if (rank == 0) {
+            total.resize(m);
+        }
+        MPI_Reduce(partial.data(), total.data(), int(3 * m), MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+        double end_time = MPI_Wtime();
+        numPoints += m;
+
+        if (rank == 0) {
+            if (batchMode) {
+                if (!writer->write(block.data(), total.data(), m)) {
+                    cerr << "Error: Unable to write the results to " << options.outputFile << endl;
+                    MPI_Abort(MPI_COMM_WORLD, 1);
+                }
+            } else {
+                const Field& E = total[0];
+                double Enorm = sqrt(E.Ex * E.Ex + E.Ey * E.Ey + E.Ez * E.Ez);
+                cout << "The electric field at (" << block[0].x << ", " << block[0].y << " ," << block[0].z
+                     << ") in V/m is\n";
+                cout << "Ex = " << formatScientific(E.Ex) << "\n";
+                cout << "Ey = " << formatScientific(E.Ey) << "\n";
+                cout << "Ez = " << formatScientific(E.Ez) << "\n";
+                cout << "|E| = " << formatScientific(Enorm) << "\n";
+                cout << "The calculation took " << (end_time - start_time)*1e6 << " microseconds!\n";
+            }
+        }
+    }
+
+    if (rank == 0 && batchMode) {
+        if (!writer->close()) {
+            cerr << "Error: Unable to write the results to " << options.outputFile << endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        double batch_time = MPI_Wtime() - batch_start;
+        cerr << "Evaluated " << numPoints << " points on " << size << " ranks in " << batch_time*1e6
+             << " microseconds (" << (batch_time > 0.0 ? numPoints / batch_time : 0.0) << " points/s)\n";
+        if (queries->getSkippedLines() > 0) {
+            cerr << "Skipped " << queries->getSkippedLines() << " malformed lines in " << options.queryFile << "\n";
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
@@ -1,6 +1,6 @@
 /*
 Author:  Yang Gu
-Date last modified: 20/9/2023
+Date last modified: 17/10/2026
 Organization: ECE6122 Class
 
 Description:
@@ -14,6 +14,8 @@ Source code of the utilities functions.
 #include <cmath>
 #include <iomanip>
 #include <sstream>
+#include <cstring>
+#include <cstdlib>
 
 double sum(const std::vector<double>& vec) {
     double res = 0.0;
@@ -119,3 +121,188 @@ bool getChoice(){
     }
     return choice=='Y';
 }
+
+bool parseOptions(int argc, char* argv[], SolverOptions& options){
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-B") == 0 && i + 1 < argc) {
+            options.backend = argv[++i];
+            if (options.backend != "direct" && options.backend != "tree" && options.backend != "volume"
+                && options.backend != "ewald") {
+                std::cerr << "Unknown backend: " << options.backend << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            options.theta = atof(argv[++i]);
+            if (options.theta <= 0.0 || options.theta >= 1.0) {
+                std::cerr << "The opening angle must be between 0 and 1." << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "-S") == 0) {
+            options.singlePrecision = true;
+        } else if (strcmp(argv[i], "-F") == 0 && i + 2 < argc) {
+            options.mapHeight = atof(argv[++i]);
+            options.mapFile = argv[++i];
+        } else if (strcmp(argv[i], "-M") == 0 && i + 1 < argc) {
+            options.mapMargin = atoi(argv[++i]);
+            if (options.mapMargin < 0) {
+                std::cerr << "The field-map margin must not be negative." << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "-A") == 0 && i + 1 < argc) {
+            options.tuneFile = argv[++i];
+        } else if (strcmp(argv[i], "-L") == 0 && i + 6 < argc) {
+            options.threads = atoi(argv[++i]);
+            options.rows = atoi(argv[++i]);
+            options.cols = atoi(argv[++i]);
+            options.xSeparation = atof(argv[++i]);
+            options.ySeparation = atof(argv[++i]);
+            options.q = atof(argv[++i]);
+            if (options.threads <= 0 || options.rows <= 0 || options.cols <= 0
+                || options.xSeparation <= 0.0 || options.ySeparation <= 0.0) {
+                std::cerr << "The thread count, rows, columns and separations must be positive." << std::endl;
+                return false;
+            }
+            options.latticeGiven = true;
+        } else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+            options.chargeFile = argv[++i];
+        } else if (strcmp(argv[i], "-Q") == 0 && i + 1 < argc) {
+            options.queryFile = argv[++i];
+        } else if (strcmp(argv[i], "-O") == 0 && i + 1 < argc) {
+            options.outputFile = argv[++i];
+        } else if (strcmp(argv[i], "-G") == 0) {
+            options.allTerms = true;
+        } else if (strcmp(argv[i], "-V") == 0 && i + 9 < argc) {
+            for (int b = 0; b < 6; ++b) {
+                options.volumeBox[b] = atof(argv[++i]);
+            }
+            for (int n = 0; n < 3; ++n) {
+                options.volumeNodes[n] = atoi(argv[++i]);
+            }
+            if (options.volumeBox[1] <= options.volumeBox[0] || options.volumeBox[3] <= options.volumeBox[2]
+                || options.volumeBox[5] <= options.volumeBox[4] || options.volumeNodes[0] < 2
+                || options.volumeNodes[1] < 2 || options.volumeNodes[2] < 2) {
+                std::cerr << "The volume box must have positive extents and at least 2 nodes along each axis."
+                          << std::endl;
+                return false;
+            }
+            options.volumeGiven = true;
+        } else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+            options.affinity = argv[++i];
+        } else if (strcmp(argv[i], "-I") == 0) {
+            options.instrument = true;
+        } else if (strcmp(argv[i], "-D") == 0) {
+            options.deterministic = true;
+        } else if (strcmp(argv[i], "-R") == 0 && i + 4 < argc) {
+            options.seedFile = argv[++i];
+            options.lineFile = argv[++i];
+            options.lineLength = atof(argv[++i]);
+            options.lineTolerance = atof(argv[++i]);
+            if (options.lineLength <= 0.0 || options.lineTolerance <= 0.0) {
+                std::cerr << "The field-line length and tolerance must be positive." << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "-N") == 0 && i + 6 < argc) {
+            options.dynamicsSteps = atoi(argv[++i]);
+            options.timeStep = atof(argv[++i]);
+            options.softening = atof(argv[++i]);
+            options.mass = atof(argv[++i]);
+            options.checkpointEvery = atoi(argv[++i]);
+            options.checkpointFile = argv[++i];
+            if (options.dynamicsSteps <= 0 || options.timeStep <= 0.0 || options.softening <= 0.0
+                || options.mass <= 0.0 || options.checkpointEvery <= 0) {
+                std::cerr << "The steps, time step, softening, mass and checkpoint interval must be positive."
+                          << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "-E") == 0 && i + 2 < argc) {
+            options.ewaldRealCutoff = atof(argv[++i]);
+            options.ewaldReciprocalCutoff = atof(argv[++i]);
+            if (options.ewaldRealCutoff <= 0.0 || options.ewaldReciprocalCutoff <= 0.0) {
+                std::cerr << "The Ewald cutoffs must be positive." << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "-W") == 0 && i + 9 < argc) {
+            for (int b = 0; b < 6; ++b) {
+                options.gridBox[b] = atof(argv[++i]);
+            }
+            for (int n = 0; n < 3; ++n) {
+                options.gridNodes[n] = atoi(argv[++i]);
+            }
+            for (int a = 0; a < 3; ++a) {
+                if (options.gridNodes[a] < 1 || options.gridBox[2 * a + 1] < options.gridBox[2 * a]
+                    || (options.gridNodes[a] > 1 && options.gridBox[2 * a + 1] == options.gridBox[2 * a])) {
+                    std::cerr << "The probe grid needs at least 1 node along each axis, and a positive extent"
+                              << " along every axis with more than 1." << std::endl;
+                    return false;
+                }
+            }
+            options.gridGiven = true;
+        } else if (strcmp(argv[i], "-Z") == 0 && i + 1 < argc) {
+            options.volumeZScale = atof(argv[++i]);
+            if (options.volumeZScale < 0.0) {
+                std::cerr << "The grading scale must not be negative." << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [-B <direct|tree|volume|ewald>] [-T <opening angle>] [-S]"
+                      << " [-F <z> <map file>] [-M <margin>] [-A <tuning file>]"
+                      << " [-L <threads> <rows> <cols> <x sep> <y sep> <q>] [-C <charge file>]"
+                      << " [-Q <query file>] [-O <output file>] [-G]"
+                      << " [-V <x0> <x1> <y0> <y1> <z0> <z1> <nx> <ny> <nz>] [-Z <z grading scale>]"
+                      << " [-P <none|compact|scatter|cpu list>] [-I] [-D]"
+                      << " [-R <seed file> <line file> <max length> <tolerance>]"
+                      << " [-N <steps> <time step> <softening> <mass> <checkpoint every> <checkpoint file>]"
+                      << " [-E <real cutoff> <reciprocal cutoff>]"
+                      << " [-W <x0> <x1> <y0> <y1> <z0> <z1> <nx> <ny> <nz>]" << std::endl;
+            return false;
+        }
+    }
+    if (!options.queryFile.empty() && options.gridGiven) {
+        std::cerr << "Streamed queries (-Q) and the probe grid (-W) are separate modes." << std::endl;
+        return false;
+    }
+    const bool batchMode = !options.queryFile.empty() || options.gridGiven;
+    if (batchMode && !options.latticeGiven && options.chargeFile.empty()) {
+        // The prompts would share stdin and stdout with the streamed queries
+        std::cerr << "Streaming queries with -Q or -W needs the lattice parameters from -L or a charge file from -C."
+                  << std::endl;
+        return false;
+    }
+    if ((options.backend == "volume") != options.volumeGiven) {
+        std::cerr << "The volume backend (-B volume) and its box (-V) are given together." << std::endl;
+        return false;
+    }
+    if (options.allTerms && (!batchMode || options.backend != "direct")) {
+        std::cerr << "The potential and field gradient (-G) are written by the direct backend in batch mode (-Q, -W)."
+                  << std::endl;
+        return false;
+    }
+    if (!options.seedFile.empty() && batchMode) {
+        std::cerr << "Field lines (-R) and streamed queries (-Q, -W) are separate modes." << std::endl;
+        return false;
+    }
+    if (options.dynamicsSteps > 0 && (batchMode || !options.seedFile.empty())) {
+        std::cerr << "The N-body mode (-N) is separate from streamed queries (-Q, -W) and field lines (-R)."
+                  << std::endl;
+        return false;
+    }
+    if (options.dynamicsSteps > 0 && options.backend != "direct") {
+        // The tree and the volume hold fixed charges and have no softening
+        std::cerr << "The N-body mode (-N) uses the direct backend." << std::endl;
+        return false;
+    }
+    if (options.backend == "ewald" && !options.chargeFile.empty()) {
+        std::cerr << "The Ewald backend (-B ewald) repeats the lattice cell and cannot use a charge file (-C)."
+                  << std::endl;
+        return false;
+    }
+    if (options.ewaldRealCutoff > 0.0 && options.backend != "ewald") {
+        std::cerr << "The Ewald cutoffs (-E) are only used by the Ewald backend (-B ewald)." << std::endl;
+        return false;
+    }
+    if (!options.mapFile.empty() && !options.chargeFile.empty()) {
+        std::cerr << "The field map (-F) needs the regular lattice and cannot use a charge file (-C)." << std::endl;
+        return false;
+    }
+    return true;
+}
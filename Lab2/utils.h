@@ -1,6 +1,6 @@
 /*
 Author:  Yang Gu
-Date last modified: 03/10/2023
+Date last modified: 17/10/2026
 Organization: ECE6122 Class
 
 Description:
@@ -13,9 +13,57 @@ Header file of the utilities functions.
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <cstddef>
 #include <vector>
 #include <string>
 
+/**
+ * Options selected on the command line.
+ */
+struct SolverOptions {
+    std::string backend = "direct"; // "direct" brute-force sum, "tree" Barnes-Hut octree, "volume" interpolation
+                                    // or "ewald" periodic sheet
+    double theta = 0.5;             // opening angle of the tree backend
+    bool singlePrecision = false;   // float kernel with double block sums for the direct backend
+    std::string mapFile;            // output of the FFT field-map mode, empty when disabled
+    double mapHeight = 0.0;         // height z of the field-map plane
+    int mapMargin = 0;              // extra field-map points on each side of the lattice
+    std::string tuneFile;           // autotuned configuration file, empty when disabled
+    std::string chargeFile;         // mapped charge-set file replacing the lattice, empty when disabled
+    bool latticeGiven = false;      // lattice given with -L instead of prompted for
+    int threads = 0;                // lattice parameters of -L, in the order of getBasicInfo
+    int rows = 0;
+    int cols = 0;
+    double xSeparation = 0.0;
+    double ySeparation = 0.0;
+    double q = 0.0;
+    std::string queryFile;          // streamed query points ("-" for stdin), empty for the prompts
+    std::string outputFile = "-";   // results of the batch queries: CSV, ".bin" records, ".col" columns or ".vtk"
+    bool gridGiven = false;         // probe grid swept in batch mode given with -W
+    double gridBox[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0}; // xMin xMax yMin yMax zMin zMax of the probe grid
+    int gridNodes[3] = {0, 0, 0};   // probe points along x, y and z
+    bool allTerms = false;          // streamed queries also write the potential and field gradient
+    bool volumeGiven = false;       // box and node counts of the volume backend given with -V
+    double volumeBox[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0}; // xMin xMax yMin yMax zMin zMax
+    int volumeNodes[3] = {0, 0, 0}; // nodes along x, y and z
+    double volumeZScale = -1.0;     // grading scale of the z nodes, negative for the lattice spacing
+    std::string affinity = "none";  // pinning of the OpenMP threads: none, compact, scatter or a CPU list
+    std::string seedFile;           // seed points of the field-line tracer, empty when disabled
+    std::string lineFile;           // traced polylines, ".vtk" for VTK polydata
+    double lineLength = 0.0;        // arc length after which a field line ends
+    double lineTolerance = 0.0;     // local error of one integration step in meters
+    bool instrument = false;        // per-thread times, counters and imbalance of every interactive query
+    bool deterministic = false;     // sums bit-identical for any thread count (fixed blocks, pairwise tree)
+    int dynamicsSteps = 0;          // time steps of the N-body mode, 0 when disabled
+    double timeStep = 0.0;          // time step of the N-body mode in seconds
+    double softening = 0.0;         // softening length of the N-body forces in meters
+    double mass = 0.0;              // mass of every charge in kg
+    int checkpointEvery = 0;        // steps between checkpoints and energy reports
+    std::string checkpointFile;     // positions and velocities of the charges at every checkpoint
+    double ewaldRealCutoff = 0.0;   // real-space cutoff of the Ewald backend in meters, 0 for automatic
+    double ewaldReciprocalCutoff = 0.0; // reciprocal-space cutoff of the Ewald backend in 1/m, 0 for automatic
+};
+
 /**
  * Computes the sum of all elements in a vector.
  *
@@ -61,4 +109,22 @@ void getXYZ(double &x, double &y, double &z);
  */
 bool getChoice();
 
+/**
+ * Parses the command line options of the solver.
+ * Usage: my_program [-B <direct|tree|volume|ewald>] [-T <opening angle>] [-S] [-F <z> <map file>] [-M <margin>]
+ *                   [-A <tuning file>] [-L <threads> <rows> <cols> <x sep> <y sep> <q>] [-C <charge file>]
+ *                   [-Q <query file>] [-O <output file>] [-G]
+ *                   [-V <x0> <x1> <y0> <y1> <z0> <z1> <nx> <ny> <nz>] [-Z <z grading scale>]
+ *                   [-P <none|compact|scatter|cpu list>] [-I] [-D]
+ *                   [-R <seed file> <line file> <max length> <tolerance>]
+ *                   [-N <steps> <time step> <softening> <mass> <checkpoint every> <checkpoint file>]
+ *                   [-E <real cutoff> <reciprocal cutoff>] [-W <x0> <x1> <y0> <y1> <z0> <z1> <nx> <ny> <nz>]
+ *
+ * @param argc          Number of command line arguments.
+ * @param argv          Array of command line arguments.
+ * @param options       Reference to store the parsed options.
+ * @return              True if all options are valid, false otherwise.
+ */
+bool parseOptions(int argc, char* argv[], SolverOptions& options);
+
 #endif //UTILS_H
@@ -21,6 +21,8 @@ the performance of three different types of CUDA memory allocation:
 #include <cstring>
 #include <cstdlib>
 
+#include "cpuRandomWalk.h"
+
 /**
  * CUDA kernel to simulate random walks.
  * @param x - Pointer to the array storing x-coordinates of walkers.
@@ -181,6 +183,15 @@ int main(int argc, char **argv) {
 
     std::cout << "Lab4 -W " << num_walkers << " -I " << num_steps << std::endl;
 
+    // Without a CUDA device, the CPU engine walks the same kind of walkers
+    int deviceCount = 0;
+    if (cudaGetDeviceCount(&deviceCount) != cudaSuccess || deviceCount == 0) {
+        std::cout << "No CUDA device found, using the CPU engine" << std::endl;
+        performRandomWalkCPU(num_walkers, num_steps);
+        std::cout << "Bye" << std::endl;
+        return 0;
+    }
+
     cudaDeviceProp deviceProp;
     cudaGetDeviceProperties(&deviceProp, 0);
     int blockSize = deviceProp.maxThreadsPerBlock / 4;
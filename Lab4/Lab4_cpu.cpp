@@ -0,0 +1,67 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+CPU version of the Lab4 2D random walk simulation, for machines without a
+CUDA device. It takes the same -W and -I options as Lab4 and reports the
+time, the average distance from the origin and the walker steps per second.
+With -E the endpoints are sampled directly instead of walked step by step;
+with -V both engines run and their endpoint distributions are compared.
+Usage: Lab4_cpu -W <number of walkers> -I <number of steps> [-T <threads>] [-S <seed>] [-E | -V]
+
+*/
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
+#include "cpuRandomWalk.h"
+
+int main(int argc, char **argv) {
+    int num_walkers = 0;
+    int num_steps = 0;
+    int num_threads = 0;
+    uint32_t seed = 0;
+    bool endpoint = false;
+    bool validate = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-W") == 0 && i + 1 < argc) {
+            num_walkers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-I") == 0 && i + 1 < argc) {
+            num_steps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc) {
+            seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "-E") == 0) {
+            endpoint = true;
+        } else if (strcmp(argv[i], "-V") == 0) {
+            validate = true;
+        } else {
+            num_walkers = 0;
+            break;
+        }
+    }
+    if (num_walkers <= 0 || num_steps <= 0 || num_threads < 0 || (endpoint && validate)) {
+        std::cerr << "Usage: " << argv[0] << " -W <number of walkers> -I <number of steps> [-T <threads>] [-S <seed>]"
+                  << " [-E | -V]" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Lab4 -W " << num_walkers << " -I " << num_steps << std::endl;
+
+    if (validate) {
+        if (!validateEndpointCPU(num_walkers, num_steps, num_threads, seed)) {
+            return 1;
+        }
+    } else {
+        performRandomWalkCPU(num_walkers, num_steps, num_threads, seed, endpoint);
+    }
+
+    std::cout << "Bye" << std::endl;
+    return 0;
+}
@@ -0,0 +1,366 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+Implementation of the CPU random-walk engine. Each 2-bit field of a random
+word is one step: 00 is +x, 01 is -x, 10 is +y and 11 is -y. With the low
+bits l and the high bits h of the 16 fields of a word,
+    dx = popcount(~h & ~l) - popcount(~h & l)
+    dy = popcount(h & ~l) - popcount(h & l)
+so a word moves a walker 16 steps at once.
+
+The endpoint mode splits the multinomial of the four direction counts into
+binomials with p = 1/2: n_x ~ B(I, 1/2) steps go along x and the rest along
+y, and n_+x ~ B(n_x, 1/2) of the x steps go to +x, so x = 2 n_+x - n_x.
+Small binomials are population counts of fair bits; larger ones come from
+Hormann's BTRS transformed rejection, which needs about 2.3 uniforms on
+average whatever n is.
+
+*/
+
+#include "cpuRandomWalk.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static const uint32_t PHILOX_M0 = 0xD2511F53u;
+static const uint32_t PHILOX_M1 = 0xCD9E8D57u;
+static const uint32_t PHILOX_W0 = 0x9E3779B9u;
+static const uint32_t PHILOX_W1 = 0xBB67AE85u;
+static const uint32_t LOW_BITS = 0x55555555u;   // the low bit of every 2-bit field
+static const int STEPS_PER_BLOCK = 64;          // 128 bits of a Philox block, 2 bits per step
+static const int BTRS_MIN_TRIALS = 20;          // n p >= 10 for BTRS; fewer trials are counted bit by bit
+
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) {
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+        const uint64_t p0 = uint64_t(PHILOX_M0) * c0;
+        const uint64_t p1 = uint64_t(PHILOX_M1) * c2;
+        c0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+        c2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+        c1 = uint32_t(p1);
+        c3 = uint32_t(p0);
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+/**
+ * Walks a group of up to WALK_LANES consecutive walkers, one vector lane per walker.
+ * @param x - Array receiving the final x-coordinates of the group.
+ * @param y - Array receiving the final y-coordinates of the group.
+ * @param first_walker - Index of the first walker of the group.
+ * @param lanes - Number of walkers in the group.
+ * @param num_steps - Number of steps for each walker.
+ * @param seed - Seed of the generator.
+ */
+static void walkGroup(int *x, int *y, uint32_t first_walker, int lanes, int num_steps, uint32_t seed) {
+    int32_t dx[WALK_LANES] = {0}, dy[WALK_LANES] = {0};
+    const int num_blocks = (num_steps + STEPS_PER_BLOCK - 1) / STEPS_PER_BLOCK;
+
+    for (int j = 0; j < num_blocks; ++j) {
+        // The last block may only use the first fields of its words
+        const int steps = std::min(STEPS_PER_BLOCK, num_steps - j * STEPS_PER_BLOCK);
+        uint32_t masks[4];
+        for (int w = 0; w < 4; ++w) {
+            const int fields = std::max(0, std::min(16, steps - 16 * w));
+            masks[w] = fields == 16 ? LOW_BITS : LOW_BITS & ((1u << (2 * fields)) - 1u);
+        }
+
+        // One lane per walker, with no dependence between lanes, so the loop is vectorized across walkers
+        for (int l = 0; l < WALK_LANES; ++l) {
+            uint32_t c[4] = {uint32_t(j), 0, first_walker + uint32_t(l), 0};
+            uint32_t k0 = seed, k1 = 0;
+            #pragma GCC unroll 10
+            for (int round = 0; round < 10; ++round) {
+                const uint64_t p0 = uint64_t(PHILOX_M0) * c[0];
+                const uint64_t p1 = uint64_t(PHILOX_M1) * c[2];
+                c[0] = uint32_t(p1 >> 32) ^ c[1] ^ k0;
+                c[2] = uint32_t(p0 >> 32) ^ c[3] ^ k1;
+                c[1] = uint32_t(p1);
+                c[3] = uint32_t(p0);
+                k0 += PHILOX_W0;
+                k1 += PHILOX_W1;
+            }
+            #pragma GCC unroll 4
+            for (int w = 0; w < 4; ++w) {
+                const uint32_t low = c[w] & masks[w];
+                const uint32_t high = (c[w] >> 1) & masks[w];
+                dx[l] += __builtin_popcount(~high & ~low & masks[w]) - __builtin_popcount(~high & low);
+                dy[l] += __builtin_popcount(high & ~low) - __builtin_popcount(high & low);
+            }
+        }
+    }
+
+    for (int l = 0; l < lanes; ++l) {
+        x[l] = dx[l];
+        y[l] = dy[l];
+    }
+}
+
+/**
+ * Runs a function on every group of WALK_LANES walkers, in balanced contiguous ranges of groups per thread.
+ * @param num_walkers - Total number of walkers.
+ * @param num_threads - Number of threads, 0 for all hardware threads.
+ * @param group - Called with the first walker and the number of walkers of each group.
+ */
+template<typename Group>
+static void forEachGroup(int num_walkers, int num_threads, Group group) {
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Whole groups per thread, in balanced contiguous ranges
+    const long num_groups = (long(num_walkers) + WALK_LANES - 1) / WALK_LANES;
+    num_threads = int(std::min<long>(num_threads, std::max(1L, num_groups)));
+
+    auto work = [&](int id) {
+        const long first = num_groups * id / num_threads;
+        const long last = num_groups * (id + 1) / num_threads;
+        for (long g = first; g < last; ++g) {
+            const long walker = g * WALK_LANES;
+            group(walker, int(std::min<long>(WALK_LANES, num_walkers - walker)));
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int id = 1; id < num_threads; ++id) {
+        threads.emplace_back(work, id);
+    }
+    work(0);
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
+void randomWalkCPU(int *x, int *y, int num_steps, int num_walkers, int num_threads, uint32_t seed) {
+    forEachGroup(num_walkers, num_threads, [=](long walker, int lanes) {
+        walkGroup(x + walker, y + walker, uint32_t(walker), lanes, num_steps, seed);
+    });
+}
+
+/**
+ * The random words of one walker in endpoint mode: the Philox blocks with
+ * counter {j, 1, w, 0} for j = 0, 1, ..., so they never repeat the words of the step mode.
+ */
+class PhiloxStream {
+    uint32_t ctr[4];
+    uint32_t key[2];
+    uint32_t words[4];
+    int used;
+
+public:
+    PhiloxStream(uint32_t walker, uint32_t seed) : ctr{0, 1, walker, 0}, key{seed, 0}, used(4) {}
+
+    uint32_t nextWord() {
+        if (used == 4) {
+            philox4x32(ctr, key, words);
+            ++ctr[0];
+            used = 0;
+        }
+        return words[used++];
+    }
+
+    // A uniform in the open interval (0, 1) with 53 random bits
+    double nextUniform() {
+        const uint64_t high = nextWord() >> 5, low = nextWord() >> 6;
+        return (double((high << 26) | low) + 0.5) * 0x1.0p-53;
+    }
+};
+
+/**
+ * The tail log(k!) - [(k + 1/2) log(k + 1) - (k + 1) + log(2 pi) / 2] of the Stirling series.
+ */
+static double stirlingTail(double k) {
+    static const double tail[10] = {0.0810614667953272, 0.0413406959554092, 0.0276779256849983,
+                                    0.0207906721037658, 0.0166446911898213, 0.0138761288230729,
+                                    0.0118967099458933, 0.0104112652619737, 0.0092554621827095,
+                                    0.0083305634333595};
+    if (k <= 9) {
+        return tail[int(k)];
+    }
+    const double kp1sq = (k + 1) * (k + 1);
+    return (1.0 / 12 - (1.0 / 360 - 1.0 / 1260 / kp1sq) / kp1sq) / (k + 1);
+}
+
+/**
+ * Draws from the binomial distribution B(n, 1/2) in expected O(1) time.
+ * @param n - Number of trials.
+ * @param stream - The walker's random words.
+ * @return The number of successes.
+ */
+static int binomialHalf(int n, PhiloxStream& stream) {
+    if (n < BTRS_MIN_TRIALS) {
+        return __builtin_popcount(stream.nextWord() & ((1u << n) - 1u));
+    }
+    // BTRS (W. Hormann, 1993) with p = 1 - p = 1/2, so r = p / (1 - p) = 1
+    const double spq = std::sqrt(n * 0.25);
+    const double b = 1.15 + 2.53 * spq;
+    const double a = -0.0873 + 0.0248 * b + 0.01 * 0.5;
+    const double c = n * 0.5 + 0.5;
+    const double v_r = 0.92 - 4.2 / b;
+    const double alpha = (2.83 + 5.1 / b) * spq;
+    const double m = std::floor((n + 1) * 0.5);
+    while (true) {
+        const double u = stream.nextUniform() - 0.5;
+        double v = stream.nextUniform();
+        const double us = 0.5 - std::fabs(u);
+        const double k = std::floor((2 * a / us + b) * u + c);
+        if (us >= 0.07 && v <= v_r) {
+            return int(k);
+        }
+        if (k < 0 || k > n) {
+            continue;
+        }
+        v = std::log(v * alpha / (a / (us * us) + b));
+        const double bound = (m + 0.5) * std::log((m + 1) / (n - m + 1)) + (n + 1) * std::log((n - m + 1) / (n - k + 1))
+                             + (k + 0.5) * std::log((n - k + 1) / (k + 1)) + stirlingTail(m) + stirlingTail(n - m)
+                             - stirlingTail(k) - stirlingTail(n - k);
+        if (v <= bound) {
+            return int(k);
+        }
+    }
+}
+
+void randomWalkEndpointCPU(int *x, int *y, int num_steps, int num_walkers, int num_threads, uint32_t seed) {
+    forEachGroup(num_walkers, num_threads, [=](long walker, int lanes) {
+        for (long w = walker; w < walker + lanes; ++w) {
+            PhiloxStream stream(uint32_t(w), seed);
+            const int along_x = binomialHalf(num_steps, stream);
+            const int along_y = num_steps - along_x;
+            x[w] = 2 * binomialHalf(along_x, stream) - along_x;
+            y[w] = 2 * binomialHalf(along_y, stream) - along_y;
+        }
+    });
+}
+
+double averageDistanceCPU(const int *x, const int *y, int num_walkers) {
+    double total_distance = 0.0;
+    for (int i = 0; i < num_walkers; ++i) {
+        total_distance += std::sqrt(double(x[i]) * x[i] + double(y[i]) * y[i]);
+    }
+    return num_walkers > 0 ? total_distance / num_walkers : 0.0;
+}
+
+void performRandomWalkCPU(int num_walkers, int num_steps, int num_threads, uint32_t seed, bool endpoint) {
+    std::vector<int> x(num_walkers), y(num_walkers);
+    auto start = std::chrono::high_resolution_clock::now();
+    if (endpoint) {
+        randomWalkEndpointCPU(x.data(), y.data(), num_steps, num_walkers, num_threads, seed);
+    } else {
+        randomWalkCPU(x.data(), y.data(), num_steps, num_walkers, num_threads, seed);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    double avg_distance = averageDistanceCPU(x.data(), y.data(), num_walkers);
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << (endpoint ? "CPU Philox random walk (endpoint sampling):" : "CPU Philox random walk:") << std::endl;
+    std::cout << "    Time to calculate(microsec): " << duration.count() << std::endl;
+    std::cout << "    Average distance from origin: " << avg_distance << std::endl;
+    std::cout << "    Walker steps per second: " << (seconds > 0.0 ? double(num_walkers) * num_steps / seconds : 0.0)
+              << std::endl;
+}
+
+/**
+ * The sample mean and the standard error of the mean.
+ * @param values - The samples.
+ * @param mean - Receives the mean.
+ * @param error - Receives the standard error of the mean.
+ */
+static void meanAndError(const std::vector<double>& values, double& mean, double& error) {
+    const double n = double(values.size());
+    double sum = 0.0, squares = 0.0;
+    for (double v : values) {
+        sum += v;
+    }
+    mean = sum / n;
+    for (double v : values) {
+        squares += (v - mean) * (v - mean);
+    }
+    error = n > 1 ? std::sqrt(squares / (n - 1) / n) : 0.0;
+}
+
+/**
+ * The two-sample Kolmogorov-Smirnov statistic, the largest gap between the empirical distribution functions.
+ * @param a - The first sample, sorted on return.
+ * @param b - The second sample, sorted on return.
+ * @return The statistic D.
+ */
+static double kolmogorovSmirnov(std::vector<double>& a, std::vector<double>& b) {
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    size_t i = 0, j = 0;
+    double gap = 0.0;
+    while (i < a.size() && j < b.size()) {
+        // Step past every copy of the smaller value, so ties move both functions together
+        const double v = std::min(a[i], b[j]);
+        while (i < a.size() && a[i] == v) {
+            ++i;
+        }
+        while (j < b.size() && b[j] == v) {
+            ++j;
+        }
+        gap = std::max(gap, std::fabs(double(i) / a.size() - double(j) / b.size()));
+    }
+    return gap;
+}
+
+bool validateEndpointCPU(int num_walkers, int num_steps, int num_threads, uint32_t seed) {
+    std::vector<int> x[2], y[2];
+    std::vector<double> distance[2], squared[2], x_coord[2];
+    double seconds[2];
+    for (int e = 0; e < 2; ++e) {
+        x[e].resize(num_walkers);
+        y[e].resize(num_walkers);
+        auto start = std::chrono::high_resolution_clock::now();
+        if (e == 1) {
+            randomWalkEndpointCPU(x[e].data(), y[e].data(), num_steps, num_walkers, num_threads, seed);
+        } else {
+            randomWalkCPU(x[e].data(), y[e].data(), num_steps, num_walkers, num_threads, seed);
+        }
+        seconds[e] = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        for (int i = 0; i < num_walkers; ++i) {
+            const double r2 = double(x[e][i]) * x[e][i] + double(y[e][i]) * y[e][i];
+            distance[e].push_back(std::sqrt(r2));
+            squared[e].push_back(r2);
+            x_coord[e].push_back(x[e][i]);
+        }
+    }
+
+    // Both samples should match each other, and E[x^2 + y^2] = I holds exactly for the walk
+    double mean[2], error[2], mean_r2[2], error_r2[2];
+    bool passed = true;
+    std::cout << "Endpoint sampling against the step engine, " << num_walkers << " walkers of " << num_steps
+              << " steps:" << std::endl;
+    for (int e = 0; e < 2; ++e) {
+        meanAndError(distance[e], mean[e], error[e]);
+        meanAndError(squared[e], mean_r2[e], error_r2[e]);
+        const double z = error_r2[e] > 0.0 ? (mean_r2[e] - num_steps) / error_r2[e] : 0.0;
+        passed = passed && std::fabs(z) < 4.0;
+        std::cout << (e == 0 ? "    Step engine:     " : "    Endpoint engine: ") << seconds[e] * 1e6
+                  << " microseconds, distance " << mean[e] << " +- " << error[e] << ", x^2 + y^2 " << mean_r2[e]
+                  << " +- " << error_r2[e] << " (z = " << z << " against " << num_steps << ")" << std::endl;
+    }
+    const double z = (mean[1] - mean[0]) / std::sqrt(error[0] * error[0] + error[1] * error[1] + 1e-300);
+    // Two-sample KS critical value at a significance level of 0.001, conservative for lattice points
+    const double critical = 1.95 * std::sqrt(2.0 / num_walkers);
+    const double ks_distance = kolmogorovSmirnov(distance[0], distance[1]);
+    const double ks_x = kolmogorovSmirnov(x_coord[0], x_coord[1]);
+    passed = passed && std::fabs(z) < 4.0 && ks_distance < critical && ks_x < critical;
+    std::cout << "    Distance difference z = " << z << std::endl;
+    std::cout << "    Kolmogorov-Smirnov D: distance " << ks_distance << ", x " << ks_x << " (critical " << critical
+              << ")" << std::endl;
+    std::cout << "    " << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed;
+}
@@ -0,0 +1,100 @@
+/*
+Author:  Yang Gu
+Date last modified: 17/10/2026
+Organization: ECE6122 Class
+
+Description:
+
+CPU engine for the 2D random walk of randomWalkKernel, for machines without
+a CUDA device. Every walker starts at the origin and takes num_steps unit
+steps, each one of +x, -x, +y, -y with probability 1/4.
+
+The moves come from the counter-based Philox4x32-10 generator: walker w
+takes its steps 64j .. 64j+63 from the 128 bits of Philox(counter =
+{j, 0, w, 0}, key = {seed, 0}), two bits per step in the order
++x, -x, +y, -y of the kernel's quartiles. A walker's path depends only on
+its index and the seed, never on the thread count or the SIMD width, and
+any walker can be replayed on its own.
+
+Walkers are processed in groups of WALK_LANES whose generator rounds run
+side by side in vector registers; the step counts of a 32-bit word are
+population counts of its bit patterns.
+
+For long walks where only the endpoint matters, randomWalkEndpointCPU draws
+the endpoint directly from the multinomial of the four direction counts, by
+binomial splitting, at an O(1) cost per walker whatever the step count. It
+has the same distribution as the step engine but not the same draws.
+
+*/
+
+#ifndef CPU_RANDOM_WALK_H
+#define CPU_RANDOM_WALK_H
+
+#include <cstdint>
+
+static const int WALK_LANES = 16; // walkers whose generators run side by side
+
+/**
+ * One Philox4x32-10 block: 4 random 32-bit words for a counter and a key.
+ * @param ctr - The 4-word counter.
+ * @param key - The 2-word key.
+ * @param out - The 4 output words.
+ */
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+
+/**
+ * Simulates random walks on the CPU with the same moves as randomWalkKernel.
+ * @param x - Array receiving the final x-coordinates of the walkers.
+ * @param y - Array receiving the final y-coordinates of the walkers.
+ * @param num_steps - Number of steps for each walker.
+ * @param num_walkers - Total number of walkers.
+ * @param num_threads - Number of threads sharing the walkers, 0 for all hardware threads.
+ * @param seed - Seed of the generator; walker streams differ for every seed.
+ */
+void randomWalkCPU(int *x, int *y, int num_steps, int num_walkers, int num_threads = 0, uint32_t seed = 0);
+
+/**
+ * Samples the endpoints of the random walks directly, in O(1) expected time per walker.
+ * @param x - Array receiving the final x-coordinates of the walkers.
+ * @param y - Array receiving the final y-coordinates of the walkers.
+ * @param num_steps - Number of steps for each walker.
+ * @param num_walkers - Total number of walkers.
+ * @param num_threads - Number of threads sharing the walkers, 0 for all hardware threads.
+ * @param seed - Seed of the generator.
+ */
+void randomWalkEndpointCPU(int *x, int *y, int num_steps, int num_walkers, int num_threads = 0, uint32_t seed = 0);
+
+/**
+ * Calculate the average distance of walkers from the origin, summed in double.
+ * @param x - Array of x-coordinates.
+ * @param y - Array of y-coordinates.
+ * @param num_walkers - Number of walkers.
+ * @return The average distance.
+ */
+double averageDistanceCPU(const int *x, const int *y, int num_walkers);
+
+/**
+ * Conducts the random walk on the CPU and prints out the time, the average
+ * distance and the walker steps per second, in the format of the CUDA runs.
+ * @param num_walkers - Number of walkers.
+ * @param num_steps - Number of steps for each walker.
+ * @param num_threads - Number of threads, 0 for all hardware threads.
+ * @param seed - Seed of the generator.
+ * @param endpoint - True to sample the endpoints directly instead of walking every step.
+ */
+void performRandomWalkCPU(int num_walkers, int num_steps, int num_threads = 0, uint32_t seed = 0,
+                          bool endpoint = false);
+
+/**
+ * Runs both engines and tests that their endpoints agree in distribution: the
+ * mean distances, the mean of x^2 + y^2 against its exact value num_steps,
+ * and two-sample Kolmogorov-Smirnov tests of the distances and x-coordinates.
+ * @param num_walkers - Number of walkers of each engine.
+ * @param num_steps - Number of steps for each walker.
+ * @param num_threads - Number of threads, 0 for all hardware threads.
+ * @param seed - Seed of the generator.
+ * @return True if every test passed.
+ */
+bool validateEndpointCPU(int num_walkers, int num_steps, int num_threads = 0, uint32_t seed = 0);
+
+#endif // CPU_RANDOM_WALK_H
@@ -1,12 +1,15 @@
 /*
 Author: Yang Gu
-Date last modified: 20/11/2023
+Date last modified: 17/10/2026
 Organization: ECE6122 Class
 
 Description:
 This C++ program uses the SFML Network library to create a TCP client that connects to a server, 
 sends and receives messages based on user inputs. It supports message versioning, sending typed messages, 
 and quitting the session. The program uses multi-threading to handle asynchronous message receiving.
+The command "f x y z" asks the server for the electric field at a point (message type 30, answered by
+type 31). Started with a connection count and a query count, the client instead measures the round-trip
+throughput of field queries: every connection keeps QUERY_WINDOW queries of POINTS_PER_MSG points in flight.
 */
 
 #include <SFML/Network.hpp>
@@ -18,6 +21,10 @@ and quitting the session. The program uses multi-threading to handle asynchronou
 #include <stdio.h>
 #include <string.h>
 #include <chrono>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
 
 struct tcpMessage {
     unsigned char nVersion;
@@ -29,6 +36,110 @@ struct tcpMessage {
 std::mutex msgMutex;
 tcpMessage lastReceivedMsg;
 
+const unsigned char MSG_FIELD_QUERY = 30;
+const unsigned char MSG_FIELD_RESULT = 31;
+const std::size_t POINTS_PER_MSG = sizeof(tcpMessage::chMsg) / (3 * sizeof(double));
+const int QUERY_WINDOW = 32;    // queries a benchmark connection keeps in flight
+
+/**
+ * Receives one whole message on a blocking socket; TCP may deliver it in several pieces.
+ *
+ * @param socket The socket to receive from.
+ * @param msg Reference to store the message.
+ * @return True if a whole message was received, false if the connection failed.
+ */
+bool receiveMessage(sf::TcpSocket& socket, tcpMessage& msg) {
+    char* data = reinterpret_cast<char*>(&msg);
+    std::size_t total = 0;
+    while (total < sizeof(msg)) {
+        std::size_t received = 0;
+        if (socket.receive(data + total, sizeof(msg) - total, received) != sf::Socket::Done) {
+            return false;
+        }
+        total += received;
+    }
+    return true;
+}
+
+/**
+ * Sends field queries over one connection and waits for all results, keeping QUERY_WINDOW in flight.
+ *
+ * @param serverIP The address of the server.
+ * @param port The port of the server.
+ * @param numQueries The number of query messages to send.
+ * @param seed Seed of the random query points.
+ * @param points Reference to store the number of points answered.
+ */
+void runQueries(const std::string& serverIP, unsigned short port, int numQueries, unsigned seed, long& points) {
+    points = 0;
+    sf::TcpSocket socket;
+    if (socket.connect(serverIP, port) != sf::Socket::Done) {
+        std::cerr << "Connection to server failed" << std::endl;
+        return;
+    }
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> coordinate(-1.0, 1.0);
+
+    tcpMessage query;
+    query.nVersion = 102;
+    query.nType = MSG_FIELD_QUERY;
+    query.nMsgLen = static_cast<unsigned short>(POINTS_PER_MSG * 3 * sizeof(double));
+    int sentQueries = 0, answered = 0;
+    while (answered < numQueries) {
+        while (sentQueries < numQueries && sentQueries - answered < QUERY_WINDOW) {
+            double coords[3 * POINTS_PER_MSG];
+            for (std::size_t p = 0; p < POINTS_PER_MSG; ++p) {
+                coords[3 * p] = coordinate(generator);
+                coords[3 * p + 1] = coordinate(generator);
+                coords[3 * p + 2] = 0.1 + std::abs(coordinate(generator));
+            }
+            memcpy(query.chMsg, coords, sizeof(coords));
+            std::size_t sent = 0;
+            if (socket.send(&query, sizeof(query), sent) != sf::Socket::Done) {
+                return;
+            }
+            ++sentQueries;
+        }
+        tcpMessage reply;
+        if (!receiveMessage(socket, reply)) {
+            return;
+        }
+        if (reply.nType == MSG_FIELD_RESULT) {
+            points += reply.nMsgLen / (3 * sizeof(double));
+            ++answered;
+        }
+    }
+    socket.disconnect();
+}
+
+/**
+ * Measures the round-trip throughput of field queries over several concurrent connections.
+ *
+ * @param serverIP The address of the server.
+ * @param port The port of the server.
+ * @param numConnections The number of connections, one thread each.
+ * @param numQueries The number of query messages per connection.
+ */
+void benchmarkQueries(const std::string& serverIP, unsigned short port, int numConnections, int numQueries) {
+    std::vector<std::thread> threads;
+    std::vector<long> points(numConnections, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < numConnections; ++c) {
+        threads.emplace_back(runQueries, serverIP, port, numQueries, unsigned(c + 1), std::ref(points[c]));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    long total = 0;
+    for (long p : points) {
+        total += p;
+    }
+    std::cout << numConnections << " connections answered " << total << " points in " << seconds << " s ("
+              << (seconds > 0.0 ? total / seconds : 0.0) << " points/s, "
+              << (seconds > 0.0 ? numConnections * double(numQueries) / seconds : 0.0) << " queries/s)" << std::endl;
+}
+
 /**
  * Receives messages from the server and updates the last received message.
  * 
@@ -63,8 +174,8 @@ void receiveMessages(sf::TcpSocket& socket, std::atomic<bool>& running, std::ato
  * @return Returns 0 on successful execution, 1 on failure.
  */
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <server_ip> <port_number>\n";
+    if (argc != 3 && argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " <server_ip> <port_number> [<connections> <queries per connection>]\n";
         return 1;
     }
 
@@ -72,6 +183,11 @@ int main(int argc, char* argv[]) {
     std::string serverIP = argv[1];
     unsigned short port = std::stoi(argv[2]);
 
+    if (argc == 5) {
+        benchmarkQueries(serverIP, port, std::stoi(argv[3]), std::stoi(argv[4]));
+        return 0;
+    }
+
     if (socket.connect(serverIP, port) != sf::Socket::Done) {
         std::cerr << "Connection to server failed" << std::endl;
         return 1;
@@ -90,7 +206,13 @@ int main(int argc, char* argv[]) {
         {        
             std::lock_guard<std::mutex> guard(msgMutex);
             received.load();
-            if (received) {
+            if (received && lastReceivedMsg.nType == MSG_FIELD_RESULT) {
+                double field[3] = {0.0, 0.0, 0.0};
+                memcpy(field, lastReceivedMsg.chMsg, std::min<std::size_t>(lastReceivedMsg.nMsgLen, sizeof(field)));
+                std::cout << "Received field: Ex = " << field[0] << ", Ey = " << field[1] << ", Ez = " << field[2]
+                    << " V/m" << std::endl;
+                received.store(false);
+            } else if (received) {
                 std::cout << "Received Msg Type: " << static_cast<int>(lastReceivedMsg.nType) 
                     << "; Msg: " << lastReceivedMsg.chMsg << std::endl;
                 received.store(false);
@@ -118,6 +240,23 @@ int main(int argc, char* argv[]) {
                 std::cerr << "Failed to send message" << std::endl;
                 running = false;
             }
+        } else if (input[0] == 'f') {
+            double point[3] = {0.0, 0.0, 0.0};
+            if (sscanf(input.c_str() + 1, "%lf %lf %lf", &point[0], &point[1], &point[2]) != 3) {
+                std::cerr << "Usage: f <x> <y> <z>" << std::endl;
+                continue;
+            }
+            tcpMessage query;
+            query.nVersion = 102;
+            query.nType = MSG_FIELD_QUERY;
+            query.nMsgLen = sizeof(point);
+            memcpy(query.chMsg, point, sizeof(point));
+
+            std::size_t sent = 0;
+            if (socket.send(&query, sizeof(query), sent) != sf::Socket::Done) {
+                std::cerr << "Failed to send message" << std::endl;
+                running = false;
+            }
         } else if (input[0] == 'q') {
             running = false;
             socket.disconnect();
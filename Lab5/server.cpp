@@ -1,6 +1,6 @@
 /*
 Author:  Yang Gu
-Date last modified: 20/11/2023
+Date last modified: 17/10/2026
 Organization: ECE6122 Class
 
 Description:
@@ -9,6 +9,18 @@ It accepts connections from multiple clients, handles client messages in separat
 The server can broadcast messages, reverse and send back messages, and list connected clients.
 It's designed to run continuously, processing client commands and managing client connections asynchronously. 
 The server can be terminated through a command, closing all client connections gracefully.
+
+Given a charge lattice on the command line, the server also answers electric-field queries. The lattice stays
+loaded in a Lab2 ECE_ChargeArray, and a query engine thread gathers the query messages of all clients and
+answers everything that arrived during one tick with a single batched evaluateField call, so the OpenMP
+kernel runs on large batches however the points are spread over the clients:
+    type 30 (query)   chMsg holds nMsgLen / 24 points as x, y, z doubles (at most 41 per message)
+    type 31 (result)  chMsg holds the Ex, Ey, Ez doubles of the same points in V/m, in the same order
+Results go back to every client in the order of its queries; without a lattice the results are empty.
+
+Every client is shared between its handler thread and the engine, so its socket lives until both are
+done with it. Sends go through sendMessage, one message at a time per client and with a send timeout:
+a client that stops reading is dropped instead of stalling the engine and the other clients.
 */
 
 #include <SFML/Network.hpp>
@@ -21,6 +33,15 @@ The server can be terminated through a command, closing all client connections g
 #include <stdio.h>
 #include <string.h>
 #include <condition_variable>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <omp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "ECE_ChargeArray.h"
 
 struct tcpMessage {
     unsigned char nVersion;
@@ -29,26 +50,207 @@ struct tcpMessage {
     char chMsg[1000];
 };
 
-std::vector<sf::TcpSocket*> clients;
+/**
+ * A connected client: its socket and the lock that keeps its outgoing messages whole.
+ */
+struct Client {
+    sf::TcpSocket socket;
+    std::mutex sendMutex;               // held for the whole of one message
+    std::atomic<bool> dropped{false};   // a send failed or the server is closing; no more sends
+};
+
+std::vector<std::shared_ptr<Client>> clients;
 std::mutex clientsMutex;
 tcpMessage lastReceivedMsg;
 std::mutex lastMsgMutex;
 std::atomic<bool> serverRunning(true);
 
+const unsigned char MSG_FIELD_QUERY = 30;   // batch of query points
+const unsigned char MSG_FIELD_RESULT = 31;  // fields at the points of one query
+const std::size_t POINTS_PER_MSG = sizeof(tcpMessage::chMsg) / (3 * sizeof(double));
+const std::chrono::microseconds QUERY_TICK(500);   // queries arriving within one tick share a batch
+const std::size_t MAX_BATCH_POINTS = 1 << 16;      // a full batch is evaluated before the tick ends
+const long SEND_TIMEOUT_SECONDS = 2;               // a client that does not read for this long is dropped
+
+/**
+ * The points of one query message and the client waiting for them.
+ */
+struct PendingQuery {
+    std::shared_ptr<Client> client;
+    std::size_t numPoints;
+    double coords[3 * POINTS_PER_MSG];
+};
+
+ECE_ChargeArray charges;            // resident charge lattice, empty when no lattice was given
+std::vector<PendingQuery> pendingQueries;
+std::size_t pendingPoints = 0;
+std::chrono::steady_clock::time_point firstPendingTime; // arrival of the oldest queued query
+std::mutex queryMutex;              // guards pendingQueries, pendingPoints and firstPendingTime
+std::condition_variable queryReady;
+std::atomic<int> activeHandlers(0); // client threads still running
+std::mutex handlersMutex;
+std::condition_variable handlersDone;
+std::atomic<unsigned long> queryTicks(0);
+std::atomic<unsigned long> queryMessages(0);
+std::atomic<unsigned long> queryPoints(0);
+std::atomic<unsigned long> queryBusyMicroseconds(0);
+
+/**
+ * Receives one whole message; TCP may deliver it in several pieces.
+ *
+ * @param socket The socket to receive from.
+ * @param msg Reference to store the message.
+ * @return True if a whole message was received, false if the connection failed.
+ */
+bool receiveMessage(sf::TcpSocket& socket, tcpMessage& msg) {
+    char* data = reinterpret_cast<char*>(&msg);
+    std::size_t total = 0;
+    while (total < sizeof(msg)) {
+        std::size_t received = 0;
+        if (socket.receive(data + total, sizeof(msg) - total, received) != sf::Socket::Done) {
+            return false;
+        }
+        total += received;
+    }
+    return true;
+}
+
+/**
+ * Stops all traffic on a client. The socket is shut down rather than closed, so its handler
+ * wakes from receive and cleans up, while the socket itself stays valid until no one uses it.
+ *
+ * @param client The client to drop.
+ */
+void dropClient(Client& client) {
+    client.dropped = true;
+    ::shutdown(client.socket.getHandle(), SHUT_RDWR);
+}
+
+/**
+ * Sends one whole message to a client, never interleaved with another message to the same client.
+ * The socket's send timeout bounds the wait; a client whose send fails or times out is dropped.
+ *
+ * @param client The client to send to.
+ * @param msg The message.
+ * @return True if the whole message was sent.
+ */
+bool sendMessage(Client& client, const tcpMessage& msg) {
+    std::lock_guard<std::mutex> guard(client.sendMutex);
+    if (client.dropped) {
+        return false;
+    }
+    std::size_t sent = 0;
+    if (client.socket.send(&msg, sizeof(msg), sent) != sf::Socket::Done || sent != sizeof(msg)) {
+        dropClient(client);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Queues the points of a query message for the next tick of the query engine.
+ *
+ * @param client The client that sent the query.
+ * @param msg The query message.
+ */
+void queueQuery(const std::shared_ptr<Client>& client, const tcpMessage& msg) {
+    PendingQuery query;
+    query.client = client;
+    query.numPoints = std::min<std::size_t>(msg.nMsgLen / (3 * sizeof(double)), POINTS_PER_MSG);
+    memcpy(query.coords, msg.chMsg, query.numPoints * 3 * sizeof(double));
+    {
+        std::lock_guard<std::mutex> guard(queryMutex);
+        if (pendingQueries.empty()) {
+            firstPendingTime = std::chrono::steady_clock::now();
+        }
+        pendingQueries.push_back(query);
+        pendingPoints += query.numPoints;
+    }
+    queryReady.notify_one();
+}
+
+/**
+ * Answers the queued field queries, one batched evaluation per tick. A tick ends QUERY_TICK after
+ * the oldest queued query arrived, or once MAX_BATCH_POINTS points are queued; everything queued
+ * by then is evaluated together and the results are sent back query by query. Queries that arrive
+ * while a batch is evaluated have already waited, so under load the ticks follow back to back.
+ *
+ * @param serverRunning Atomic flag indicating if the server is running.
+ */
+void runQueryEngine(std::atomic<bool>& serverRunning) {
+    std::vector<PendingQuery> batch;
+    std::vector<Point> points;
+    std::vector<Field> fields;
+    std::vector<tcpMessage> replies;
+
+    while (serverRunning) {
+        {
+            std::unique_lock<std::mutex> lock(queryMutex);
+            if (!queryReady.wait_for(lock, std::chrono::milliseconds(100),
+                                     [&serverRunning] { return !pendingQueries.empty() || !serverRunning; })) {
+                continue;
+            }
+            queryReady.wait_until(lock, firstPendingTime + QUERY_TICK,
+                                  [&serverRunning] { return pendingPoints >= MAX_BATCH_POINTS || !serverRunning; });
+            batch.swap(pendingQueries);
+            pendingQueries.clear();
+            pendingPoints = 0;
+        }
+        if (batch.empty()) {
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        points.clear();
+        for (const PendingQuery& query : batch) {
+            for (std::size_t p = 0; p < query.numPoints; ++p) {
+                points.push_back(Point{query.coords[3 * p], query.coords[3 * p + 1], query.coords[3 * p + 2]});
+            }
+        }
+        fields.resize(points.size());
+        if (charges.size() > 0 && !points.empty()) {
+            charges.evaluateField(points.data(), points.size(), fields.data());
+        }
+
+        // The replies are built first and sent without any global lock; the batch keeps every client alive
+        std::size_t offset = 0;
+        replies.resize(batch.size());
+        for (std::size_t b = 0; b < batch.size(); ++b) {
+            tcpMessage& reply = replies[b];
+            reply.nVersion = 102;
+            reply.nType = MSG_FIELD_RESULT;
+            reply.nMsgLen = 0;
+            if (charges.size() > 0) {
+                reply.nMsgLen = static_cast<unsigned short>(batch[b].numPoints * 3 * sizeof(double));
+                memcpy(reply.chMsg, &fields[offset], reply.nMsgLen);
+            }
+            offset += batch[b].numPoints;
+        }
+        for (std::size_t b = 0; b < batch.size(); ++b) {
+            sendMessage(*batch[b].client, replies[b]);
+        }
+
+        queryTicks += 1;
+        queryMessages += batch.size();
+        queryPoints += points.size();
+        queryBusyMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        batch.clear();
+    }
+}
+
 /**
  * Handles communication with a connected client.
  * 
- * @param clientSocket Pointer to the socket connected to the client.
+ * @param client The connected client, shared with the query engine.
  * @param serverRunning Atomic flag indicating if the server is running.
  */
-void handleClient(sf::TcpSocket* clientSocket, std::atomic<bool>& serverRunning) {
+void handleClient(std::shared_ptr<Client> client, std::atomic<bool>& serverRunning) {
     while (serverRunning) {
         tcpMessage msg;
-        std::size_t received;
-        std::size_t sent;
 
         // Receive a message from the client
-        if (clientSocket->receive(&msg, sizeof(msg), received) != sf::Socket::Done) {
+        if (!receiveMessage(client->socket, msg)) {
             break;
         }
 
@@ -62,27 +264,47 @@ void handleClient(sf::TcpSocket* clientSocket, std::atomic<bool>& serverRunning)
 
         // Handle different message types
         if (msg.nType == 77) { // Broadcast to all except sender
-            std::lock_guard<std::mutex> guard(clientsMutex);
-            for (auto& client : clients) {
-                if (client != clientSocket) {
-                    client->send(&msg, sizeof(msg), sent);
+            std::vector<std::shared_ptr<Client>> others;
+            {
+                std::lock_guard<std::mutex> guard(clientsMutex);
+                others = clients;
+            }
+            for (auto& other : others) {
+                if (other != client) {
+                    sendMessage(*other, msg);
                 }
             }
         } else if (msg.nType == 201) { // Reverse message and send back
             std::reverse(msg.chMsg, msg.chMsg + strlen(msg.chMsg));
-            clientSocket->send(&msg, sizeof(msg), sent);
+            sendMessage(*client, msg);
+        } else if (msg.nType == MSG_FIELD_QUERY) { // Field query, answered by the query engine
+            queueQuery(client, msg);
         }
     }
 
-    // Clean up the client socket
+    // Remove the client and its queued queries; a batch in flight still holds it until its replies are sent
     {
         std::lock_guard<std::mutex> guard(clientsMutex);
-        auto it = std::find(clients.begin(), clients.end(), clientSocket);
+        auto it = std::find(clients.begin(), clients.end(), client);
         if (it != clients.end()) {
             clients.erase(it); 
         }
     }
-    delete clientSocket;
+    {
+        std::lock_guard<std::mutex> guard(queryMutex);
+        auto first = std::remove_if(pendingQueries.begin(), pendingQueries.end(),
+                                    [&client](const PendingQuery& query) { return query.client == client; });
+        for (auto it = first; it != pendingQueries.end(); ++it) {
+            pendingPoints -= it->numPoints;
+        }
+        pendingQueries.erase(first, pendingQueries.end());
+    }
+    client.reset();
+
+    std::lock_guard<std::mutex> guard(handlersMutex);
+    if (--activeHandlers == 0) {
+        handlersDone.notify_all();
+    }
 }
 
 /**
@@ -95,15 +317,17 @@ void acceptClients(sf::TcpListener& listener, std::atomic<bool>& serverRunning)
     listener.setBlocking(false);
 
     while (serverRunning) {
-        sf::TcpSocket* client = new sf::TcpSocket;
-        if (listener.accept(*client) == sf::Socket::Done) {
+        std::shared_ptr<Client> client = std::make_shared<Client>();
+        if (listener.accept(client->socket) == sf::Socket::Done) {
+            // Bound every send, so that a client that stops reading cannot block its senders for good
+            timeval timeout = {SEND_TIMEOUT_SECONDS, 0};
+            setsockopt(client->socket.getHandle(), SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
             {
                 std::lock_guard<std::mutex> guard(clientsMutex);
                 clients.push_back(client);
             }
+            ++activeHandlers;
             std::thread(handleClient, client, std::ref(serverRunning)).detach();
-        } else {
-            delete client;
         }
     }
 }
@@ -118,23 +342,48 @@ std::string getClientList() {
     std::stringstream ss;
     ss << "Number of Clients: " << clients.size() << "\n";
     for (auto& client : clients) {
-        sf::IpAddress ip = client->getRemoteAddress();
-        unsigned short port = client->getRemotePort();
+        sf::IpAddress ip = client->socket.getRemoteAddress();
+        unsigned short port = client->socket.getRemotePort();
         ss << "IP Address: " << ip << " | Port: " << port << "\n";
     }
     return ss.str();
 }
 
 /**
- * Closes all client connections and clears the clients list.
+ * Shuts down all client connections and waits for their handlers, which remove and free the clients.
  */
 void closeAllClients() {
-    std::lock_guard<std::mutex> guard(clientsMutex);
-    for (auto& client : clients) {
-        client->disconnect();
-        delete client;
+    {
+        std::lock_guard<std::mutex> guard(clientsMutex);
+        for (auto& client : clients) {
+            dropClient(*client);
+        }
     }
-    clients.clear();
+    std::unique_lock<std::mutex> lock(handlersMutex);
+    handlersDone.wait(lock, [] { return activeHandlers == 0; });
+}
+
+/**
+ * Fills the resident charge array with a rows x cols lattice centred on the origin, as Lab2 does,
+ * and declares it a lattice so the queries use the lattice kernel.
+ *
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ * @param xSeparation Distance between columns in meters.
+ * @param ySeparation Distance between rows in meters.
+ * @param q Charge of every point in micro Coulomb.
+ */
+void loadLattice(int rows, int cols, double xSeparation, double ySeparation, double q) {
+    const double halfRow = double(rows - 1.0) / 2.0 * ySeparation;
+    const double halfCol = double(cols - 1.0) / 2.0 * xSeparation;
+    const std::size_t n = std::size_t(rows) * cols;
+    charges.resize(n);
+    // Same static split as the kernel, so first touch places every range with its thread
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < long(n); ++i) {
+        charges.setCharge(i, (i % cols) * xSeparation - halfCol, (i / cols) * ySeparation - halfRow, 0, q);
+    }
+    charges.setLattice(rows, cols, -halfCol, -halfRow, xSeparation, ySeparation);
 }
 
 /**
@@ -146,13 +395,22 @@ void closeAllClients() {
  * @return Returns 0 on successful execution, 1 on failure.
  */
 int main(int argc, char* argv[]) {
-    if (argc != 2){
-        std::cerr << "Usage: " << argv[0] << " <port_number>\n";
+    if (argc != 2 && argc != 7){
+        std::cerr << "Usage: " << argv[0] << " <port_number> [<rows> <cols> <x sep> <y sep> <q>]\n";
         return 1;
     }
+    if (argc == 7) {
+        int rows = std::stoi(argv[2]), cols = std::stoi(argv[3]);
+        double xSeparation = std::stod(argv[4]), ySeparation = std::stod(argv[5]), q = std::stod(argv[6]);
+        if (rows <= 0 || cols <= 0 || xSeparation <= 0.0 || ySeparation <= 0.0) {
+            std::cerr << "The lattice needs positive rows, columns and separations\n";
+            return 1;
+        }
+        loadLattice(rows, cols, xSeparation, ySeparation, q);
+        std::cout << "Serving field queries for a " << rows << " x " << cols << " lattice\n";
+    }
 
     sf::TcpListener listener;
-    std::vector<std::thread> clientThreads;
     unsigned short port = std::stoi(argv[1]);
 
     if (listener.listen(port) != sf::Socket::Done) {
@@ -162,6 +420,8 @@ int main(int argc, char* argv[]) {
 
     // Accept clients in a separate thread
     std::thread acceptThread(acceptClients, std::ref(listener), std::ref(serverRunning));
+    // Answer field queries in batches in another
+    std::thread engineThread(runQueryEngine, std::ref(serverRunning));
     
     // Command loop
     while (serverRunning) {
@@ -174,6 +434,12 @@ int main(int argc, char* argv[]) {
             std::cout << "Last Message: " << lastReceivedMsg.chMsg << "\n";
         } else if (command == "clients") {
             std::cout << getClientList();
+        } else if (command == "queries") {
+            unsigned long ticks = queryTicks, messages = queryMessages, points = queryPoints;
+            double busy = queryBusyMicroseconds * 1e-6;
+            std::cout << "Field queries: " << messages << " messages, " << points << " points in " << ticks
+                      << " batches (" << (ticks > 0 ? double(points) / ticks : 0.0) << " points per batch), "
+                      << busy << " s evaluating and sending\n";
         } else if (command == "exit") {
             serverRunning = false;
             listener.close(); 
@@ -181,6 +447,8 @@ int main(int argc, char* argv[]) {
     }
 
     acceptThread.join();
+    queryReady.notify_all();
+    engineThread.join();
     closeAllClients();
 
     return 0;